@@ -0,0 +1,701 @@
+
+#include "benchmark.hpp"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "barrier.hpp"
+#include "binary_semaphore.hpp"
+#include "condition_variable.hpp"
+#include "deferred_work.hpp"
+#include "driver/gptimer.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "event_group.hpp"
+#include "fixed_pool.hpp"
+#include "latch.hpp"
+#include "load_balancer.hpp"
+#include "mpmc_queue.hpp"
+#include "mutex.hpp"
+#include "mutex_locker.hpp"
+#include "pipeline.hpp"
+#include "queue.hpp"
+#include "task.hpp"
+#include "triple_buffer.hpp"
+
+#if FREERTOS_UTILS_BENCHMARK
+
+namespace {
+
+constexpr uint16_t kWorkerStackSize{4096U};
+
+/**
+ * @brief Benchmark worker task running a function object
+ *
+ */
+class Worker : public Task {
+public:
+  Worker(const std::function<void()>& body, const BaseType_t core_id, const uint8_t priority)
+  : Task("Benchmark", kWorkerStackSize, priority, core_id), body_{body} {
+  }
+
+  void run(void* data) override {
+    body_();
+  }
+
+private:
+  std::function<void()> body_;
+};
+
+/*
+  Run body(index) in count workers, worker i runs on core i % portNUM_PROCESSORS. The workers are
+  released together once all of them are created. Returns when all workers have finished.
+*/
+void runWorkers(const uint32_t count, const std::function<void(uint32_t)>& body) {
+  const uint8_t priority{static_cast<uint8_t>(uxTaskPriorityGet(nullptr))};
+  Latch go{1U};
+  std::vector<std::unique_ptr<Worker>> workers;
+  workers.reserve(count);
+  for (uint32_t i = 0U; i < count; ++i) {
+    workers.emplace_back(new Worker(
+        [&go, &body, i]() {
+          go.wait();
+          body(i);
+        },
+        static_cast<BaseType_t>(i % portNUM_PROCESSORS), priority));
+  }
+  for (auto& worker : workers) {
+    worker->start();
+  }
+  go.countDown();
+  for (auto& worker : workers) {
+    worker->join();
+  }
+}
+
+uint8_t lowerPriority() {
+  const UBaseType_t priority{uxTaskPriorityGet(nullptr)};
+  return static_cast<uint8_t>((priority > tskIDLE_PRIORITY + 1U) ? priority - 1U : tskIDLE_PRIORITY + 1U);
+}
+
+uint8_t higherPriority() {
+  const UBaseType_t priority{uxTaskPriorityGet(nullptr) + 1U};
+  return static_cast<uint8_t>((priority < configMAX_PRIORITIES) ? priority : configMAX_PRIORITIES - 1U);
+}
+
+constexpr uint32_t kTimerResolutionHz{1000000U};
+
+/**
+ * @brief Posts made from a timer ISR, post returns true if it woke a higher priority task
+ *
+ */
+struct TimerPosts {
+  bool (*post)(void* context);
+  void* context;
+  std::atomic<uint32_t> remaining;
+  uint32_t posts;
+  uint64_t cycles;
+};
+
+bool onAlarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event, void* user_ctx) {
+  TimerPosts& posts{*static_cast<TimerPosts*>(user_ctx)};
+  if (0U == posts.remaining.load()) {
+    return false;
+  }
+  posts.remaining.fetch_sub(1U);
+  const uint32_t start{CPU_CYCLE_COUNT()};
+  const bool woken{posts.post(posts.context)};
+  posts.cycles += CPU_CYCLE_COUNT() - start;
+  ++posts.posts;
+  return woken;
+}
+
+/*
+  Call posts.post() from a timer ISR rate times per second during duration_ms. The ISR runs on
+  the core of the calling task, returns once all posts are made.
+*/
+void postFromTimer(const uint32_t rate, const uint32_t duration_ms, TimerPosts& posts) {
+  posts.remaining.store(static_cast<uint32_t>(static_cast<uint64_t>(rate) * duration_ms / 1000U));
+  posts.posts = 0U;
+  posts.cycles = 0U;
+  if ((0U == rate) || (rate > kTimerResolutionHz)) {
+    posts.remaining.store(0U);
+    return;
+  }
+  gptimer_handle_t timer{nullptr};
+  gptimer_config_t config{};
+  config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  config.direction = GPTIMER_COUNT_UP;
+  config.resolution_hz = kTimerResolutionHz;
+  ESP_ERROR_CHECK(gptimer_new_timer(&config, &timer));
+  gptimer_event_callbacks_t callbacks{};
+  callbacks.on_alarm = &onAlarm;
+  ESP_ERROR_CHECK(gptimer_register_event_callbacks(timer, &callbacks, &posts));
+  gptimer_alarm_config_t alarm{};
+  alarm.alarm_count = kTimerResolutionHz / rate;
+  alarm.reload_count = 0U;
+  alarm.flags.auto_reload_on_alarm = true;
+  ESP_ERROR_CHECK(gptimer_set_alarm_action(timer, &alarm));
+  ESP_ERROR_CHECK(gptimer_enable(timer));
+  ESP_ERROR_CHECK(gptimer_start(timer));
+  Task::delay(duration_ms);
+  while (0U != posts.remaining.load()) {
+    Task::delay(1U);
+  }
+  ESP_ERROR_CHECK(gptimer_stop(timer));
+  ESP_ERROR_CHECK(gptimer_disable(timer));
+  ESP_ERROR_CHECK(gptimer_del_timer(timer));
+}
+
+uint32_t coreCount(const uint32_t cores) {
+  return ((cores > 0U) && (cores < portNUM_PROCESSORS)) ? cores : portNUM_PROCESSORS;
+}
+
+uint32_t perOperation(const uint64_t cycles, const uint64_t operations) {
+  return (operations > 0U) ? static_cast<uint32_t>(cycles / operations) : 0U;
+}
+
+void emptyWork(void* arg) {
+}
+
+constexpr size_t kWorkCapacity{256U};
+
+struct WorkItem {
+  void (*work)(void* arg);
+  void* arg;
+  uint32_t posted_at;
+};
+
+using BenchWorkQueue = DeferredWorkQueue<kWorkCapacity, 1U>;
+
+bool postDeferred(void* context) {
+  static_cast<BenchWorkQueue*>(context)->post(&emptyWork);
+  return false;
+}
+
+/**
+ * @brief Kernel queue of work items filled from the ISR
+ *
+ */
+struct WorkQueue {
+  Queue<WorkItem, kWorkCapacity> queue;
+  uint32_t dropped;
+};
+
+bool postQueued(void* context) {
+  WorkQueue& work{*static_cast<WorkQueue*>(context)};
+  const WorkItem item{&emptyWork, nullptr, CPU_CYCLE_COUNT()};
+  BaseType_t woken{pdFALSE};
+  if (pdTRUE != xQueueSendToBackFromISR(work.queue.raw(), &item, &woken)) {
+    ++work.dropped;
+  }
+  return pdFALSE != woken;
+}
+
+struct PipelineStep {
+  using input_type = uint32_t;
+  using output_type = uint32_t;
+
+  bool process(const uint32_t& in, uint32_t& out) {
+    out = in + 1U;
+    return true;
+  }
+};
+
+/*
+  Push messages from a worker and pop them here, returns cycles until the last message is popped
+*/
+template <typename P>
+uint32_t runPipeline(const uint32_t messages) {
+  std::unique_ptr<P> pipeline{new P("BenchPipe", static_cast<uint8_t>(uxTaskPriorityGet(nullptr)))};
+  pipeline->start();
+  Worker producer(
+      [&pipeline, messages]() {
+        for (uint32_t i = 0U; i < messages; ++i) {
+          pipeline->push(i);
+        }
+      },
+      0, static_cast<uint8_t>(uxTaskPriorityGet(nullptr)));
+  const uint32_t start{CPU_CYCLE_COUNT()};
+  producer.start();
+  uint32_t value{0U};
+  for (uint32_t i = 0U; i < messages; ++i) {
+    pipeline->pop(value);
+  }
+  const uint32_t elapsed{CPU_CYCLE_COUNT() - start};
+  producer.join();
+  pipeline->shutdown();
+  pipeline->join();
+  return elapsed;
+}
+
+constexpr size_t kBufferSize{8U};
+
+struct BoundedBuffer {
+  Mutex mutex;
+  ConditionVariable not_empty;
+  ConditionVariable not_full;
+  uint32_t items[kBufferSize]{};
+  size_t head{0U};
+  size_t count{0U};
+};
+
+/*
+  Wait with the mutex locked until the predicate holds, either on the condition variable or by polling
+*/
+template <typename Predicate>
+void waitUntil(Mutex& mutex, ConditionVariable& cv, const bool notify, Predicate pred) {
+  if (notify) {
+    cv.wait(mutex, pred);
+    return;
+  }
+  while (!pred()) {
+    mutex.unlock();
+    Task::delay(1U);
+    mutex.lock();
+  }
+}
+
+constexpr size_t kQueueLength{64U};
+
+/*
+  Send messages from every producer and receive all of them in one consumer,
+  returns cycles until all workers have finished
+*/
+template <typename Q>
+uint32_t runQueue(const uint32_t producers, const uint32_t messages) {
+  std::unique_ptr<Q> queue{new Q()};
+  const uint32_t start{CPU_CYCLE_COUNT()};
+  runWorkers(producers + 1U, [&](const uint32_t index) {
+    uint32_t value{0U};
+    if (index == producers) {
+      for (uint32_t i = 0U; i < producers * messages; ++i) {
+        queue->receive(value, portMAX_DELAY);
+      }
+    } else {
+      for (uint32_t i = 0U; i < messages; ++i) {
+        queue->enqueueBack(i, portMAX_DELAY);
+      }
+    }
+  });
+  return CPU_CYCLE_COUNT() - start;
+}
+
+constexpr size_t kFrameSize{4096U};
+
+struct Frame {
+  uint32_t sequence;
+  uint8_t data[kFrameSize];
+};
+
+uint32_t readFrame(const Frame& frame) {
+  uint32_t sum{0U};
+  for (const uint8_t byte : frame.data) {
+    sum += byte;
+  }
+  return sum;
+}
+
+/*
+  Account frames skipped between the previously read frame and this one
+*/
+void countDropped(const Frame& frame, uint32_t& last, uint32_t& dropped) {
+  dropped += frame.sequence - last - 1U;
+  last = frame.sequence;
+}
+
+constexpr uint32_t kChunkIterations{1000U};
+
+/**
+ * @brief Automatically placed task doing chunks of busy work until it is told to finish
+ *
+ */
+class BusyWorker : public Task {
+public:
+  BusyWorker(const std::atomic<bool>& done, const uint8_t priority)
+  : Task("BenchBusy", kWorkerStackSize, priority, kCoreAuto), done_{done} {
+  }
+
+  uint32_t chunks() const {
+    return chunks_.load();
+  }
+
+  void run(void* data) override {
+    while (!done_.load()) {
+      if (migrationRequested()) {
+        return;
+      }
+      for (uint32_t i = 0U; i < kChunkIterations; ++i) {
+        sink_ = sink_ + i;
+      }
+      chunks_.fetch_add(1U);
+    }
+  }
+
+private:
+  const std::atomic<bool>& done_;
+  std::atomic<uint32_t> chunks_{0U};
+  volatile uint32_t sink_{0U};
+};
+
+/*
+  Run busy tasks started on core 0 for duration_ms, returns work chunks completed per second
+*/
+uint32_t runBusyWorkers(const uint32_t tasks, const uint32_t duration_ms, const bool balance) {
+  const uint8_t priority{static_cast<uint8_t>(uxTaskPriorityGet(nullptr))};
+  std::atomic<bool> done{false};
+  std::vector<std::unique_ptr<BusyWorker>> workers;
+  workers.reserve(tasks);
+  for (uint32_t i = 0U; i < tasks; ++i) {
+    workers.emplace_back(new BusyWorker(done, priority));
+    /*
+      Not started task is placed on the target core when it starts
+    */
+    workers.back()->migrate(0);
+  }
+  std::unique_ptr<LoadBalancer> balancer;
+  if (balance) {
+    balancer.reset(new LoadBalancer(100U, 20U, 1U, "BenchBalancer", kWorkerStackSize, higherPriority()));
+    balancer->start();
+  }
+  for (auto& worker : workers) {
+    worker->start();
+  }
+  Task::delay(duration_ms);
+  done.store(true);
+  for (auto& worker : workers) {
+    worker->join();
+  }
+  if (balancer) {
+    balancer->stop();
+  }
+  uint64_t chunks{0U};
+  for (auto& worker : workers) {
+    chunks += worker->chunks();
+  }
+  return perOperation(chunks * 1000U, duration_ms);
+}
+
+constexpr uint32_t kMinParticipants{2U};
+constexpr uint32_t kMaxParticipants{8U};
+constexpr uint32_t kEventBanks{3U};
+
+/*
+  Event group bit of the participant in the phase, every phase uses its own bank of bits
+*/
+EventBits_t phaseBit(const uint32_t participant, const uint32_t phase) {
+  return static_cast<EventBits_t>(1UL << ((phase % kEventBanks) * kMaxParticipants + participant));
+}
+
+EventBits_t phaseBits(const uint32_t participants, const uint32_t phase) {
+  return static_cast<EventBits_t>(((1UL << participants) - 1U) << ((phase % kEventBanks) * kMaxParticipants));
+}
+
+constexpr size_t kPoolBlockSize{64U};
+constexpr uint32_t kPoolBurst{8U};
+FixedPool<kPoolBlockSize, kPoolBurst * portNUM_PROCESSORS * 2U> pool;
+
+}  // namespace
+
+Benchmark::Result Benchmark::fixedPool(const uint32_t cores, const uint32_t iterations) {
+  const uint32_t workers{coreCount(cores)};
+  std::atomic<uint64_t> pool_cycles{0U};
+  std::atomic<uint64_t> heap_cycles{0U};
+  const uint32_t bursts{iterations / kPoolBurst};
+
+  runWorkers(workers, [&](uint32_t) {
+    void* blocks[kPoolBurst];
+    const uint32_t start{CPU_CYCLE_COUNT()};
+    for (uint32_t i = 0U; i < bursts; ++i) {
+      for (void*& block : blocks) {
+        block = pool.allocate();
+      }
+      for (void* block : blocks) {
+        pool.deallocate(block);
+      }
+    }
+    pool_cycles.fetch_add(CPU_CYCLE_COUNT() - start);
+  });
+
+  runWorkers(workers, [&](uint32_t) {
+    void* blocks[kPoolBurst];
+    const uint32_t start{CPU_CYCLE_COUNT()};
+    for (uint32_t i = 0U; i < bursts; ++i) {
+      for (void*& block : blocks) {
+        block = pvPortMalloc(kPoolBlockSize);
+      }
+      for (void* block : blocks) {
+        vPortFree(block);
+      }
+    }
+    heap_cycles.fetch_add(CPU_CYCLE_COUNT() - start);
+  });
+
+  const uint64_t operations{static_cast<uint64_t>(bursts) * kPoolBurst * workers};
+  return Result{perOperation(pool_cycles.load(), operations), perOperation(heap_cycles.load(), operations)};
+}
+
+Benchmark::Latency Benchmark::deferredWork(const uint32_t rate, const uint32_t duration_ms) {
+  Latency result{};
+
+  /*
+    The timer ISR is allocated on core 0 by the worker, the draining tasks run on core 0 as well
+  */
+  {
+    BenchWorkQueue queue{"BenchWork", kWorkerStackSize, higherPriority(), 0};
+    TimerPosts posts{&postDeferred, &queue, {0U}, 0U, 0U};
+    queue.start();
+    runWorkers(1U, [&](uint32_t) { postFromTimer(rate, duration_ms, posts); });
+    while (queue.stats(0U).completed + queue.stats(0U).dropped < posts.posts) {
+      Task::delay(1U);
+    }
+    queue.stop();
+    const auto stats{queue.stats(0U)};
+    result.post_cycles.library = perOperation(posts.cycles, posts.posts);
+    result.completion_cycles.library = perOperation(stats.total_cycles, stats.completed);
+    result.dropped.library = stats.dropped;
+  }
+
+  {
+    WorkQueue work{{}, 0U};
+    TimerPosts posts{&postQueued, &work, {0U}, 0U, 0U};
+    uint64_t total_cycles{0U};
+    uint32_t completed{0U};
+    Worker consumer(
+        [&]() {
+          WorkItem item{};
+          while (work.queue.receive(item, portMAX_DELAY) && (nullptr != item.work)) {
+            item.work(item.arg);
+            total_cycles += CPU_CYCLE_COUNT() - item.posted_at;
+            ++completed;
+          }
+        },
+        0, higherPriority());
+    consumer.start();
+    runWorkers(1U, [&](uint32_t) { postFromTimer(rate, duration_ms, posts); });
+    work.queue.enqueueBack(WorkItem{nullptr, nullptr, 0U}, portMAX_DELAY);
+    consumer.join();
+    result.post_cycles.baseline = perOperation(posts.cycles, posts.posts);
+    result.completion_cycles.baseline = perOperation(total_cycles, completed);
+    result.dropped.baseline = work.dropped;
+  }
+  return result;
+}
+
+Benchmark::Result Benchmark::taskRearm(const uint32_t iterations) {
+  uint32_t cycles[2]{};
+  for (const bool park : {true, false}) {
+    Worker worker([]() {}, static_cast<BaseType_t>(CURRENT_CORE_ID()), higherPriority());
+    worker.setParkOnFinish(park);
+    /*
+      The first run creates the kernel task in both cases
+    */
+    worker.start();
+    worker.join();
+    const uint32_t start{CPU_CYCLE_COUNT()};
+    for (uint32_t i = 0U; i < iterations; ++i) {
+      worker.start();
+      worker.join();
+    }
+    cycles[park ? 0U : 1U] = CPU_CYCLE_COUNT() - start;
+  }
+  return Result{perOperation(cycles[0], iterations), perOperation(cycles[1], iterations)};
+}
+
+uint32_t Benchmark::taskRearmNotifications(const uint32_t iterations) {
+  uint32_t pending{0U};
+  Worker worker(
+      [&pending]() {
+        if (0U != ulTaskNotifyTakeIndexed(WaitList::kNotifyIndex, pdTRUE, 0U)) {
+          ++pending;
+        }
+      },
+      static_cast<BaseType_t>(CURRENT_CORE_ID()), lowerPriority());
+  worker.setParkOnFinish(true);
+  for (uint32_t i = 0U; i < iterations; ++i) {
+    worker.start();
+    worker.join();
+  }
+  return pending;
+}
+
+Benchmark::Result Benchmark::pipeline(const uint32_t messages) {
+  using Fused = Pipeline<Fuse<PipelineStep, PipelineStep, PipelineStep, PipelineStep>>;
+  using Unfused = Pipeline<PipelineStep, PipelineStep, PipelineStep, PipelineStep>;
+  return Result{perOperation(runPipeline<Fused>(messages), messages),
+                perOperation(runPipeline<Unfused>(messages), messages)};
+}
+
+Benchmark::Result Benchmark::conditionVariable(const uint32_t items) {
+  uint32_t cycles[2]{};
+  for (const bool notify : {true, false}) {
+    BoundedBuffer buffer;
+    const uint32_t start{CPU_CYCLE_COUNT()};
+    runWorkers(2U, [&](const uint32_t index) {
+      for (uint32_t i = 0U; i < items; ++i) {
+        MutexLocker lock{buffer.mutex};
+        if (0U == index) {
+          waitUntil(buffer.mutex, buffer.not_full, notify, [&]() { return buffer.count < kBufferSize; });
+          buffer.items[(buffer.head + buffer.count) % kBufferSize] = i;
+          ++buffer.count;
+          buffer.not_empty.notifyOne();
+        } else {
+          waitUntil(buffer.mutex, buffer.not_empty, notify, [&]() { return buffer.count > 0U; });
+          buffer.head = (buffer.head + 1U) % kBufferSize;
+          --buffer.count;
+          buffer.not_full.notifyOne();
+        }
+      }
+    });
+    cycles[notify ? 0U : 1U] = CPU_CYCLE_COUNT() - start;
+  }
+  return Result{perOperation(cycles[0], items), perOperation(cycles[1], items)};
+}
+
+Benchmark::Result Benchmark::mpmcQueue(const uint32_t producers_per_core, const uint32_t messages) {
+  const uint32_t producers{producers_per_core * portNUM_PROCESSORS};
+  const uint64_t total{static_cast<uint64_t>(producers) * messages};
+  return Result{perOperation(runQueue<MpmcQueue<uint32_t, kQueueLength>>(producers, messages), total),
+                perOperation(runQueue<Queue<uint32_t, kQueueLength>>(producers, messages), total)};
+}
+
+Benchmark::Handoff Benchmark::tripleBuffer(const uint32_t frames) {
+  Handoff result{};
+  std::atomic<bool> done{false};
+  uint64_t publish_cycles{0U};
+  uint64_t acquire_cycles{0U};
+  uint32_t consumed{0U};
+  uint32_t dropped{0U};
+  uint32_t last{0U};
+  volatile uint32_t sink{0U};
+
+  {
+    std::unique_ptr<TripleBuffer<Frame>> buffer{new TripleBuffer<Frame>()};
+    runWorkers(2U, [&](const uint32_t index) {
+      if (0U == index) {
+        for (uint32_t i = 1U; i <= frames; ++i) {
+          Frame& frame{buffer->back()};
+          frame.sequence = i;
+          memset(frame.data, static_cast<int>(i), kFrameSize);
+          const uint32_t start{CPU_CYCLE_COUNT()};
+          buffer->publish();
+          publish_cycles += CPU_CYCLE_COUNT() - start;
+        }
+        done.store(true);
+        return;
+      }
+      while (!done.load() || buffer->hasFrame()) {
+        if (!buffer->waitFrame(10U)) {
+          continue;
+        }
+        const uint32_t start{CPU_CYCLE_COUNT()};
+        const Frame* frame{buffer->acquire()};
+        acquire_cycles += CPU_CYCLE_COUNT() - start;
+        if (nullptr != frame) {
+          sink = readFrame(*frame);
+          countDropped(*frame, last, dropped);
+          ++consumed;
+          buffer->release(frame);
+        }
+      }
+    });
+    result.publish_cycles.library = perOperation(publish_cycles, frames);
+    result.acquire_cycles.library = perOperation(acquire_cycles, consumed);
+    result.consumed.library = consumed;
+    result.dropped.library = buffer->stats().dropped;
+  }
+
+  done.store(false);
+  publish_cycles = 0U;
+  acquire_cycles = 0U;
+  consumed = 0U;
+  dropped = 0U;
+  last = 0U;
+  {
+    std::unique_ptr<Frame> shared{new Frame()};
+    shared->sequence = 0U;
+    Mutex mutex;
+    BinarySemaphore fresh;
+    runWorkers(2U, [&](const uint32_t index) {
+      if (0U == index) {
+        for (uint32_t i = 1U; i <= frames; ++i) {
+          const uint32_t start{CPU_CYCLE_COUNT()};
+          mutex.lock();
+          const uint32_t locked{CPU_CYCLE_COUNT()};
+          shared->sequence = i;
+          memset(shared->data, static_cast<int>(i), kFrameSize);
+          const uint32_t written{CPU_CYCLE_COUNT()};
+          mutex.unlock();
+          fresh.tryGive();
+          publish_cycles += (locked - start) + (CPU_CYCLE_COUNT() - written);
+        }
+        done.store(true);
+        fresh.tryGive();
+        return;
+      }
+      while (!done.load() || (last != frames)) {
+        if (!fresh.tryTake(10U)) {
+          continue;
+        }
+        const uint32_t start{CPU_CYCLE_COUNT()};
+        mutex.lock();
+        const uint32_t locked{CPU_CYCLE_COUNT()};
+        if (shared->sequence != last) {
+          sink = readFrame(*shared);
+          countDropped(*shared, last, dropped);
+          ++consumed;
+        }
+        const uint32_t read{CPU_CYCLE_COUNT()};
+        mutex.unlock();
+        acquire_cycles += (locked - start) + (CPU_CYCLE_COUNT() - read);
+      }
+    });
+    result.publish_cycles.baseline = perOperation(publish_cycles, frames);
+    result.acquire_cycles.baseline = perOperation(acquire_cycles, consumed);
+    result.consumed.baseline = consumed;
+    result.dropped.baseline = dropped;
+  }
+  return result;
+}
+
+Benchmark::Result Benchmark::loadBalancer(const uint32_t tasks, const uint32_t duration_ms) {
+  return Result{runBusyWorkers(tasks, duration_ms, true), runBusyWorkers(tasks, duration_ms, false)};
+}
+
+Benchmark::Result Benchmark::barrier(const uint32_t participants, const uint32_t phases) {
+  const uint32_t count{(participants < kMinParticipants)   ? kMinParticipants
+                       : (participants > kMaxParticipants) ? kMaxParticipants
+                                                           : participants};
+  uint32_t cycles[2]{};
+  {
+    Barrier barrier{count};
+    const uint32_t start{CPU_CYCLE_COUNT()};
+    runWorkers(count, [&](uint32_t) {
+      for (uint32_t phase = 0U; phase < phases; ++phase) {
+        barrier.arriveAndWait();
+      }
+    });
+    cycles[0] = CPU_CYCLE_COUNT() - start;
+  }
+  {
+    EventGroup group;
+    const uint32_t start{CPU_CYCLE_COUNT()};
+    runWorkers(count, [&](const uint32_t index) {
+      for (uint32_t phase = 0U; phase < phases; ++phase) {
+        /*
+          Everybody has left the phase before the previous one, the bit of this task is reused in the next phase
+        */
+        group.clearBits(phaseBit(index, phase + 1U));
+        group.setBits(phaseBit(index, phase));
+        group.waitForAll(phaseBits(count, phase), portMAX_DELAY, false);
+      }
+    });
+    cycles[1] = CPU_CYCLE_COUNT() - start;
+  }
+  return Result{perOperation(cycles[0], phases), perOperation(cycles[1], phases)};
+}
+
+#endif // FREERTOS_UTILS_BENCHMARK
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+#include "wait_list.hpp"
+
+/**
+ * @class Barrier
+ *
+ * @brief Reusable barrier for a fixed number of participating tasks
+ *
+ * Every phase completes when all participants have called arriveAndWait(), the last one runs
+ * the completion callback and releases the rest. Waiting tasks spin for a short time, which is
+ * enough for short phases on a multi-core part, and then block on the library notification index
+ * of WaitList, index 0 is left to the application.
+ */
+class Barrier {
+public:
+  /**
+   * @brief Completion callback type
+   *
+   */
+  using completion_t = std::function<void()>;
+
+  /**
+   * @brief Default number of polling iterations before blocking
+   *
+   */
+  static constexpr uint32_t kDefaultSpinIterations{(portNUM_PROCESSORS > 1) ? 256U : 0U};
+
+  /**
+   * @brief Construct a new Barrier object
+   *
+   * @param participants number of participating tasks
+   * @param completion callback called by the last arriving task before the others are released
+   * @param spin_iterations number of polling iterations before blocking
+   */
+  explicit Barrier(const size_t participants, completion_t completion = nullptr,
+                   const uint32_t spin_iterations = kDefaultSpinIterations)
+  : participants_{participants}, completion_{completion}, spin_iterations_{spin_iterations} {
+    assert(participants_ > 0U);
+  }
+
+  Barrier(const Barrier&) = delete;
+  Barrier& operator=(const Barrier&) = delete;
+
+  /**
+   * @brief Arrive at the barrier and wait until all participants arrive
+   *
+   */
+  void arriveAndWait() {
+    assert(!IS_IN_ISR());
+    const uint32_t phase{phase_.load(std::memory_order_acquire)};
+    if (arrived_.fetch_add(1U, std::memory_order_acq_rel) + 1U == participants_) {
+      if (completion_) {
+        completion_();
+      }
+      arrived_.store(0U, std::memory_order_relaxed);
+      phase_.fetch_add(1U, std::memory_order_acq_rel);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      waiters_.notifyAll();
+      return;
+    }
+
+    for (uint32_t i = 0U; (i < spin_iterations_) && (phase == phase_.load(std::memory_order_acquire)); ++i) {
+    }
+    while (phase == phase_.load(std::memory_order_acquire)) {
+      WaitList::Waiter waiter;
+      waiters_.add(waiter);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (phase != phase_.load(std::memory_order_acquire)) {
+        waiters_.cancel(waiter);
+        break;
+      }
+      waiters_.wait(waiter, portMAX_DELAY);
+    }
+  }
+
+  /**
+   * @brief Get number of completed phases
+   *
+   * @return phase counter
+   */
+  uint32_t phase() const {
+    return phase_.load(std::memory_order_acquire);
+  }
+
+private:
+  /**
+   * @brief Number of participating tasks
+   *
+   */
+  const size_t participants_;
+
+  /**
+   * @brief Phase completion callback
+   *
+   */
+  const completion_t completion_;
+
+  /**
+   * @brief Number of polling iterations before blocking
+   *
+   */
+  const uint32_t spin_iterations_;
+
+  /**
+   * @brief Number of participants arrived in the current phase
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> arrived_{0U};
+
+  /**
+   * @brief Phase counter, incremented when the phase completes
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> phase_{0U};
+
+  /**
+   * @brief Blocked participants
+   *
+   */
+  WaitList waiters_;
+};
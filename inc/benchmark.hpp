@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * @class Benchmark
+ *
+ * @brief On-target benchmarks of the library primitives against the kernel primitives they replace
+ *
+ * Compiled only with FREERTOS_UTILS_BENCHMARK. Every routine creates its own worker tasks and
+ * objects and frees them before returning, so it can be called from a test task or a console
+ * command. Workers run with the priority of the calling task and are spread over the cores.
+ * The calling task should be pinned to a core, as cycle counters of cores are not synchronized.
+ */
+class Benchmark {
+public:
+  /**
+   * @brief Benchmark result, the library primitive against the baseline
+   *
+   */
+  struct Result {
+    uint32_t library;
+    uint32_t baseline;
+  };
+
+  /**
+   * @brief Result of a message passing benchmark
+   *
+   */
+  struct Latency {
+    Result post_cycles;
+    Result completion_cycles;
+    Result dropped;
+  };
+
+  /**
+   * @brief Result of a frame handoff benchmark
+   *
+   */
+  struct Handoff {
+    Result publish_cycles;
+    Result acquire_cycles;
+    Result consumed;
+    Result dropped;
+  };
+
+  /**
+   * @brief Measure FixedPool against pvPortMalloc/vPortFree, one worker per core allocates
+   * a burst of blocks and frees them again
+   *
+   * @param cores number of cores running a worker concurrently
+   * @param iterations number of allocations per worker
+   * @return average CPU cycles per allocate/deallocate pair
+   */
+  static Result fixedPool(uint32_t cores = 1U, uint32_t iterations = 10000U);
+
+  /**
+   * @brief Measure DeferredWorkQueue against a Queue of work items drained by a task.
+   * A gptimer ISR on core 0 posts empty work at a fixed rate, the draining task runs on the same core
+   * with a higher priority than the calling task.
+   *
+   * @param rate posts per second, up to 1000000
+   * @param duration_ms duration of every run in ms
+   * @return average CPU cycles spent in post inside the ISR and from post to completion,
+   * number of dropped posts
+   */
+  static Latency deferredWork(uint32_t rate = 50000U, uint32_t duration_ms = 1000U);
+
+  /**
+   * @brief Measure starting a parked Task again against creating a new kernel task for every run.
+   * The task runs an empty run() on the calling core with a higher priority.
+   *
+   * @param iterations number of runs
+   * @return average CPU cycles of start() and join() of one run
+   */
+  static Result taskRearm(uint32_t iterations = 1000U);
+
+  /**
+   * @brief Check that re-arming a parked Task does not leave a task notification pending. The task
+   * runs on the calling core with a lower priority, so join() returns and start() re-arms the task
+   * before it blocks in park(). The calling task should run above priority 1.
+   *
+   * @param iterations number of runs
+   * @return number of runs which found a notification pending at the start of run(), 0 expected
+   */
+  static uint32_t taskRearmNotifications(uint32_t iterations = 1000U);
+
+  /**
+   * @brief Measure a 4-stage Pipeline with every stage fused onto one task against the same
+   * chain with a task per stage. A worker pushes messages while the calling task pops them.
+   *
+   * @param messages number of messages passed through the pipeline
+   * @return average CPU cycles per message
+   */
+  static Result pipeline(uint32_t messages = 1000U);
+
+  /**
+   * @brief Measure a bounded buffer guarded by a Mutex with producer and consumer on different cores,
+   * waiting on ConditionVariable against polling with Task::delay()
+   *
+   * @param items number of items passed through the buffer
+   * @return average CPU cycles per item
+   */
+  static Result conditionVariable(uint32_t items = 10000U);
+
+  /**
+   * @brief Measure MpmcQueue against Queue with several producers on every core and one consumer
+   *
+   * @param producers_per_core number of producer tasks on every core
+   * @param messages number of messages sent by every producer
+   * @return average CPU cycles per message
+   */
+  static Result mpmcQueue(uint32_t producers_per_core = 1U, uint32_t messages = 10000U);
+
+  /**
+   * @brief Measure TripleBuffer against a single frame buffer guarded by a Mutex, the producer
+   * on core 0 writes frames as fast as it can while the consumer on core 1 reads the newest ones
+   *
+   * @param frames number of frames written by the producer
+   * @return average CPU cycles of handing a frame over on both sides excluding reading and writing
+   * the frame, number of consumed frames and frames replaced before the consumer took them
+   */
+  static Handoff tripleBuffer(uint32_t frames = 1000U);
+
+  /**
+   * @brief Measure throughput of busy automatically placed tasks all started on core 0,
+   * with a LoadBalancer running against without it. The tasks return from run() on
+   * Task::migrationRequested(), so they move on stock ESP-IDF as well. Without run time stats
+   * the balancer does not move tasks and both results are alike.
+   *
+   * @param tasks number of busy tasks
+   * @param duration_ms duration of every run in ms
+   * @return work chunks completed by all tasks per second
+   */
+  static Result loadBalancer(uint32_t tasks = 4U, uint32_t duration_ms = 2000U);
+
+  /**
+   * @brief Measure Barrier against an EventGroup barrier where every participant sets its own bit
+   * and waits for all of them. The bits of a phase are cleared two phases later, as a participant
+   * may still be about to wait on them.
+   *
+   * @param participants number of participating tasks spread over the cores, 2 to 8
+   * @param phases number of phases
+   * @return average CPU cycles per phase
+   */
+  static Result barrier(uint32_t participants = 2U, uint32_t phases = 1000U);
+};
@@ -4,6 +4,7 @@
 #include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "trace.hpp"
 
 /**
  * @class BinarySemaphore
@@ -29,7 +30,10 @@ public:
    */
   bool tryTake(const uint32_t delay_ms) {
     assert(!IS_IN_ISR());
-    return (xSemaphoreTake(handle_, pdMS_TO_TICKS(delay_ms)) != pdFALSE);
+    TRACE_START(trace_start);
+    const bool ret{xSemaphoreTake(handle_, pdMS_TO_TICKS(delay_ms)) != pdFALSE};
+    TRACE_EVENT(ret ? TraceEvent::kSemaphoreTake : TraceEvent::kSemaphoreTimeout, handle_, trace_start, 0U);
+    return ret;
   }
 
   /**
@@ -84,6 +88,7 @@ private:
    * @return true if semaphore is released successfully, otherwise false.
    */
   bool semaphoreGiveFromAnywhere() const {
+    TRACE_INSTANT(TraceEvent::kSemaphoreGive, handle_, 0U);
     bool result{false};
     if (IS_IN_ISR()) {
       BaseType_t reschedule{pdFALSE};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <assert.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "mutex.hpp"
+#include "mutex_locker.hpp"
+#include "wait_list.hpp"
+
+/**
+ * @class ConditionVariable
+ *
+ * @brief Condition variable working with Mutex and MutexLocker
+ *
+ * Waiting tasks are kept in an intrusive list and woken with direct task notifications on
+ * the library index (see WaitList), the mutex must be locked exactly once by the waiting task.
+ * Wake-ups can be spurious, use predicate overloads or re-check the condition.
+ */
+class ConditionVariable {
+public:
+  ConditionVariable() = default;
+  ConditionVariable(const ConditionVariable&) = delete;
+  ConditionVariable& operator=(const ConditionVariable&) = delete;
+
+  /**
+   * @brief Unlock the mutex, wait for notification and lock the mutex again
+   *
+   * @param mutex locked mutex
+   */
+  void wait(Mutex& mutex) {
+    waitTicks(mutex, portMAX_DELAY);
+  }
+
+  /**
+   * @brief Unlock the mutex, wait for notification with timeout and lock the mutex again
+   *
+   * @param mutex locked mutex
+   * @param timeout_ms maximum timeout specified in ms
+   * @return true if notified, false on timeout
+   */
+  bool waitFor(Mutex& mutex, const uint32_t timeout_ms) {
+    return waitTicks(mutex, pdMS_TO_TICKS(timeout_ms));
+  }
+
+  /**
+   * @brief Wait until the predicate becomes true
+   *
+   * @param mutex locked mutex
+   * @param pred condition to wait for, called with the mutex locked
+   */
+  template <typename Predicate>
+  void wait(Mutex& mutex, Predicate pred) {
+    while (!pred()) {
+      wait(mutex);
+    }
+  }
+
+  /**
+   * @brief Wait until the predicate becomes true or the timeout expires
+   *
+   * @param mutex locked mutex
+   * @param timeout_ms maximum timeout specified in ms
+   * @param pred condition to wait for, called with the mutex locked
+   * @return predicate value on return
+   */
+  template <typename Predicate>
+  bool waitFor(Mutex& mutex, const uint32_t timeout_ms, Predicate pred) {
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    TickType_t ticks{pdMS_TO_TICKS(timeout_ms)};
+    while (!pred()) {
+      if (pdFALSE != xTaskCheckForTimeOut(&timeout, &ticks)) {
+        return pred();
+      }
+      waitTicks(mutex, ticks);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Unlock the mutex held by the locker, wait for notification and lock the mutex again
+   *
+   * @param locker locker holding the mutex
+   */
+  void wait(MutexLocker& locker) {
+    wait(locker.mutex());
+  }
+
+  /**
+   * @brief Unlock the mutex held by the locker, wait for notification with timeout and lock the mutex again
+   *
+   * @param locker locker holding the mutex
+   * @param timeout_ms maximum timeout specified in ms
+   * @return true if notified, false on timeout
+   */
+  bool waitFor(MutexLocker& locker, const uint32_t timeout_ms) {
+    return waitFor(locker.mutex(), timeout_ms);
+  }
+
+  /**
+   * @brief Wait until the predicate becomes true
+   *
+   * @param locker locker holding the mutex
+   * @param pred condition to wait for, called with the mutex locked
+   */
+  template <typename Predicate>
+  void wait(MutexLocker& locker, Predicate pred) {
+    wait(locker.mutex(), pred);
+  }
+
+  /**
+   * @brief Wait until the predicate becomes true or the timeout expires
+   *
+   * @param locker locker holding the mutex
+   * @param timeout_ms maximum timeout specified in ms
+   * @param pred condition to wait for, called with the mutex locked
+   * @return predicate value on return
+   */
+  template <typename Predicate>
+  bool waitFor(MutexLocker& locker, const uint32_t timeout_ms, Predicate pred) {
+    return waitFor(locker.mutex(), timeout_ms, pred);
+  }
+
+  /**
+   * @brief Wake one waiting task. This function can be called from any context.
+   *
+   */
+  void notifyOne() {
+    waiters_.notifyOne();
+  }
+
+  /**
+   * @brief Wake all waiting tasks. This function can be called from any context.
+   *
+   */
+  void notifyAll() {
+    waiters_.notifyAll();
+  }
+
+private:
+  bool waitTicks(Mutex& mutex, const TickType_t ticks) {
+    assert(!IS_IN_ISR());
+    WaitList::Waiter waiter;
+    waiters_.add(waiter);
+    mutex.unlock();
+    const bool ret{waiters_.wait(waiter, ticks)};
+    mutex.lock();
+    return ret;
+  }
+
+  /**
+   * @brief Waiting tasks
+   *
+   */
+  WaitList waiters_;
+};
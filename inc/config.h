@@ -5,6 +5,41 @@
 
 #ifdef MCU_ESP32
 #define IS_IN_ISR() static_cast<bool>(xPortInIsrContext())
+#define CURRENT_CORE_ID() static_cast<uint32_t>(xPortGetCoreID())
+#define CPU_CYCLE_COUNT() static_cast<uint32_t>(esp_cpu_get_cycle_count())
+#define CACHE_LINE_SIZE 32U
 #endif // MCU_ESP32
 
-#endif // FREERTOS_UTILS_CONFIG_H_
\ No newline at end of file
+/*
+  Event tracing of tasks and primitives, see trace.hpp. Disabled by default,
+  enable with -DFREERTOS_UTILS_TRACE=1 in the component compile options.
+*/
+#ifndef FREERTOS_UTILS_TRACE
+#define FREERTOS_UTILS_TRACE 0
+#endif // FREERTOS_UTILS_TRACE
+
+/*
+  Number of trace records kept per core, must be a power of two
+*/
+#ifndef FREERTOS_UTILS_TRACE_DEPTH
+#define FREERTOS_UTILS_TRACE_DEPTH 256U
+#endif // FREERTOS_UTILS_TRACE_DEPTH
+
+/*
+  On-target benchmarks of the library primitives, see benchmark.hpp. Disabled by default,
+  enable with -DFREERTOS_UTILS_BENCHMARK=1 in the component compile options.
+*/
+#ifndef FREERTOS_UTILS_BENCHMARK
+#define FREERTOS_UTILS_BENCHMARK 0
+#endif // FREERTOS_UTILS_BENCHMARK
+
+/*
+  Task notification index used by tasks blocked in the library primitives, see wait_list.hpp.
+  The default index 1 keeps index 0 for the application and requires
+  CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES of at least 2.
+*/
+#ifndef FREERTOS_UTILS_WAIT_NOTIFY_INDEX
+#define FREERTOS_UTILS_WAIT_NOTIFY_INDEX 1U
+#endif // FREERTOS_UTILS_WAIT_NOTIFY_INDEX
+
+#endif // FREERTOS_UTILS_CONFIG_H_
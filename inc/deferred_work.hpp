@@ -0,0 +1,333 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <utility>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "esp_cpu.h"
+#include "task.hpp"
+
+/**
+ * @brief Template task executing work deferred from interrupts
+ *
+ * ISRs post a function and its argument into a lock-free ring without entering kernel critical
+ * sections. The task drains the ring in batches and is notified only when it went to sleep on
+ * the empty ring, so a burst of posts results in a single wake-up. Time from post to completion
+ * is accounted per work source.
+ *
+ * The task should run on the same core as the ISRs posting into it, so the cycle counter used
+ * for latency statistics is the same for both sides.
+ *
+ * @tparam Capacity ring length, power of two
+ * @tparam MaxSources number of work sources with separate statistics
+ * @tparam BatchSize number of work items executed before yielding
+ */
+template <size_t Capacity = 64U, size_t MaxSources = 8U, size_t BatchSize = 16U>
+class DeferredWorkQueue : public Task {
+public:
+  /**
+   * @brief Deferred work function type
+   *
+   */
+  using work_t = void (*)(void* arg);
+
+  /**
+   * @brief Statistics of one work source
+   *
+   */
+  struct SourceStats {
+    uint32_t completed;
+    uint32_t dropped;
+    uint32_t total_cycles;
+    uint32_t max_cycles;
+  };
+
+  /**
+   * @brief Construct a new DeferredWorkQueue object
+   *
+   * @param task_name task name
+   * @param stack_size task stack size
+   * @param priority task priority
+   * @param core_id core to run on
+   */
+  explicit DeferredWorkQueue(const std::string& task_name = "DeferredWork",
+                             const uint16_t stack_size = configMINIMAL_STACK_SIZE,
+                             const uint8_t priority = configMAX_PRIORITIES - 1U, const BaseType_t core_id = 0)
+  : Task(task_name, stack_size, priority, core_id) {
+    for (size_t i = 0U; i < Capacity; ++i) {
+      slots_[i].sequence.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Post work to be executed by the task. This function can be called from any context.
+   *
+   * @param work function to call
+   * @param arg argument passed to the function
+   * @param source work source index used for statistics, less than MaxSources
+   * @return true if the work was posted, false if the ring is full
+   */
+  bool post(work_t work, void* arg = nullptr, const uint8_t source = 0U) {
+    assert(source < MaxSources);
+    uint32_t pos{enqueue_pos_.load(std::memory_order_relaxed)};
+    Slot* slot{nullptr};
+    for (;;) {
+      slot = &slots_[pos & kMask];
+      const int32_t diff{static_cast<int32_t>(slot->sequence.load(std::memory_order_acquire) - pos)};
+      if (0 == diff) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        stats_[source].dropped.fetch_add(1U, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->work = work;
+    slot->arg = arg;
+    slot->source = source;
+    slot->posted_at = CPU_CYCLE_COUNT();
+    slot->sequence.store(pos + 1U, std::memory_order_release);
+
+    /*
+      Pairs with the fence in run(): either the task sees the published slot or this sees the armed flag
+    */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (armed_.exchange(false, std::memory_order_acq_rel)) {
+      wake();
+    }
+    return true;
+  }
+
+  /**
+   * @brief Get statistics of the work source
+   *
+   * @param source work source index
+   * @return statistics snapshot
+   */
+  SourceStats stats(const uint8_t source) const {
+    assert(source < MaxSources);
+    const Counters& counters{stats_[source]};
+    return SourceStats{counters.completed.load(std::memory_order_relaxed),
+                       counters.dropped.load(std::memory_order_relaxed),
+                       counters.total_cycles.load(std::memory_order_relaxed),
+                       counters.max_cycles.load(std::memory_order_relaxed)};
+  }
+
+private:
+  static_assert((Capacity >= 2U) && (0U == (Capacity & (Capacity - 1U))), "capacity must be a power of two");
+  static_assert(BatchSize > 0U, "batch size must be positive");
+
+  static constexpr uint32_t kMask{Capacity - 1U};
+
+  /**
+   * @brief Ring slot, sequence number tells whether it is free or holds posted work
+   *
+   */
+  struct Slot {
+    std::atomic<uint32_t> sequence{0U};
+    work_t work{nullptr};
+    void* arg{nullptr};
+    uint32_t posted_at{0U};
+    uint8_t source{0U};
+  };
+
+  /**
+   * @brief Statistics counters, only the consumer writes everything but dropped
+   *
+   */
+  struct Counters {
+    std::atomic<uint32_t> completed{0U};
+    std::atomic<uint32_t> dropped{0U};
+    std::atomic<uint32_t> total_cycles{0U};
+    std::atomic<uint32_t> max_cycles{0U};
+  };
+
+  /**
+   * @brief Check if there is no published work at the ring head
+   *
+   * @return true if the ring is empty
+   */
+  bool empty() const {
+    const uint32_t seq{slots_[dequeue_pos_ & kMask].sequence.load(std::memory_order_acquire)};
+    return static_cast<int32_t>(seq - (dequeue_pos_ + 1U)) < 0;
+  }
+
+  /**
+   * @brief Execute up to BatchSize posted work items
+   *
+   * @return number of executed items
+   */
+  size_t drain() {
+    size_t done{0U};
+    while ((done < BatchSize) && !empty()) {
+      Slot& slot{slots_[dequeue_pos_ & kMask]};
+      const work_t work{slot.work};
+      void* const arg{slot.arg};
+      const uint8_t source{slot.source};
+      const uint32_t posted_at{slot.posted_at};
+      slot.sequence.store(dequeue_pos_ + Capacity, std::memory_order_release);
+      ++dequeue_pos_;
+
+      if (nullptr != work) {
+        work(arg);
+      }
+
+      Counters& counters{stats_[source]};
+      const uint32_t latency{CPU_CYCLE_COUNT() - posted_at};
+      counters.completed.fetch_add(1U, std::memory_order_relaxed);
+      counters.total_cycles.fetch_add(latency, std::memory_order_relaxed);
+      if (latency > counters.max_cycles.load(std::memory_order_relaxed)) {
+        counters.max_cycles.store(latency, std::memory_order_relaxed);
+      }
+      ++done;
+    }
+    return done;
+  }
+
+  /**
+   * @brief Notify the sleeping task from any context
+   *
+   */
+  void wake() {
+    if (IS_IN_ISR()) {
+      BaseType_t reschedule{pdFALSE};
+      vTaskNotifyGiveFromISR(task_descr_, &reschedule);
+      portYIELD_FROM_ISR(reschedule);
+    } else {
+      xTaskNotifyGive(task_descr_);
+    }
+  }
+
+  /**
+   * @brief Drain loop
+   *
+   * @param args argument passed to the task
+   */
+  void run(void* args) override {
+    for (;;) {
+      if (BatchSize == drain()) {
+        taskYIELD();
+        continue;
+      }
+      /*
+        Arm the wake-up before the last emptiness check, so a post made in between
+        either is seen here or notifies the task
+      */
+      armed_.store(true, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (empty()) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      } else {
+        armed_.store(false, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Work ring
+   *
+   */
+  std::array<Slot, Capacity> slots_{};
+
+  /**
+   * @brief Producers position
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> enqueue_pos_{0U};
+
+  /**
+   * @brief Set while the task sleeps or is about to sleep on the empty ring
+   *
+   */
+  std::atomic<bool> armed_{false};
+
+  /**
+   * @brief Consumer position, only touched by the task
+   *
+   */
+  alignas(CACHE_LINE_SIZE) uint32_t dequeue_pos_{0U};
+
+  /**
+   * @brief Per source statistics
+   *
+   */
+  std::array<Counters, MaxSources> stats_{};
+};
+
+/**
+ * @brief Template set of deferred work queues, one per core
+ *
+ * Work posted from an ISR is executed on the core the ISR runs on.
+ *
+ * @tparam Capacity ring length of every queue, power of two
+ * @tparam MaxSources number of work sources with separate statistics
+ * @tparam BatchSize number of work items executed before yielding
+ */
+template <size_t Capacity = 64U, size_t MaxSources = 8U, size_t BatchSize = 16U>
+class DeferredWork {
+public:
+  using queue_t = DeferredWorkQueue<Capacity, MaxSources, BatchSize>;
+
+  /**
+   * @brief Construct a new DeferredWork object
+   *
+   * @param stack_size stack size of every task
+   * @param priority priority of every task
+   */
+  explicit DeferredWork(const uint16_t stack_size = configMINIMAL_STACK_SIZE,
+                        const uint8_t priority = configMAX_PRIORITIES - 1U)
+  : DeferredWork(std::make_index_sequence<portNUM_PROCESSORS>{}, stack_size, priority) {
+  }
+
+  /**
+   * @brief Start the tasks on all cores
+   *
+   */
+  void start() {
+    for (queue_t& queue : queues_) {
+      queue.start();
+    }
+  }
+
+  /**
+   * @brief Post work to the queue of the current core. This function can be called from any context.
+   *
+   * @param work function to call
+   * @param arg argument passed to the function
+   * @param source work source index used for statistics
+   * @return true if the work was posted, false if the ring is full
+   */
+  bool post(typename queue_t::work_t work, void* arg = nullptr, const uint8_t source = 0U) {
+    return queues_[CURRENT_CORE_ID()].post(work, arg, source);
+  }
+
+  /**
+   * @brief Get the queue of the core
+   *
+   * @param core_id core id
+   * @return queue object refference
+   */
+  queue_t& queue(const uint32_t core_id) {
+    return queues_[core_id];
+  }
+
+private:
+  template <size_t... Cores>
+  DeferredWork(std::index_sequence<Cores...>, const uint16_t stack_size, const uint8_t priority)
+  : queues_{{queue_t("DeferredWork" + std::to_string(Cores), stack_size, priority,
+                     static_cast<BaseType_t>(Cores))...}} {
+  }
+
+  /**
+   * @brief Queues, one per core
+   *
+   */
+  std::array<queue_t, portNUM_PROCESSORS> queues_;
+};
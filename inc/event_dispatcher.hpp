@@ -0,0 +1,256 @@
+#pragma once
+
+#include <assert.h>
+#include <array>
+#include <functional>
+#include "event_group.hpp"
+#include "task.hpp"
+
+/**
+ * @brief Template task which waits on event groups and dispatches set bits to registered handlers
+ *
+ * One dispatcher replaces several listener tasks blocked on the same event group. Handlers are
+ * registered for single events or bit masks (any-of or all-of) and are called from the dispatcher
+ * task in priority order. Bits are cleared once they were dispatched to the handlers, bits of an
+ * incomplete all-of mask are kept until the rest of the mask is set.
+ *
+ * More events than one group can hold are supported by chaining groups: the top bit of every group
+ * but the last one signals that the next group has pending bits, so the dispatcher blocks on
+ * the first group only.
+ *
+ * @tparam MaxHandlers maximum number of handlers
+ * @tparam Groups number of chained event groups
+ */
+template <size_t MaxHandlers = 16U, size_t Groups = 1U>
+class EventDispatcher : public Task {
+public:
+  /**
+   * @brief Handler type, receives the bits of its mask which triggered the call
+   *
+   */
+  using handler_t = std::function<void(EventBits_t)>;
+
+  /**
+   * @brief Number of usable bits in one event group, the top 8 bits are reserved by the kernel
+   *
+   */
+  static constexpr uint8_t kBitsPerGroup{sizeof(EventBits_t) * 8U - 8U};
+
+  /**
+   * @brief Number of events in one group, the top bit is reserved for chaining
+   *
+   */
+  static constexpr uint8_t kEventsPerGroup{(Groups > 1U) ? kBitsPerGroup - 1U : kBitsPerGroup};
+
+  /**
+   * @brief Total number of supported events
+   *
+   */
+  static constexpr size_t kMaxEvents{kEventsPerGroup * Groups};
+
+  /**
+   * @brief Construct a new EventDispatcher object
+   *
+   * @param task_name task name
+   * @param stack_size task stack size
+   * @param priority task priority
+   * @param core_id core id
+   */
+  explicit EventDispatcher(const std::string& task_name = "EventDispatcher",
+                           const uint16_t stack_size = configMINIMAL_STACK_SIZE,
+                           const uint8_t priority = kTaskDefaultPriority, const BaseType_t core_id = 0)
+  : Task(task_name, stack_size, priority, core_id) {
+  }
+
+  /**
+   * @brief Register handler for a single event, must be called before start()
+   *
+   * @param event_id event index, less than kMaxEvents
+   * @param handler handler to call
+   * @param priority dispatch priority, handlers with higher value are called first
+   * @return true if the handler was registered, false if there is no free handler slot
+   */
+  bool on(const uint16_t event_id, handler_t handler, const uint8_t priority = 0U) {
+    return onAny(bitOf(event_id), std::move(handler), priority, groupOf(event_id));
+  }
+
+  /**
+   * @brief Register handler called when any bit of the mask is set, must be called before start()
+   *
+   * @param mask event bits within the group
+   * @param handler handler to call
+   * @param priority dispatch priority, handlers with higher value are called first
+   * @param group event group index
+   * @return true if the handler was registered, false if there is no free handler slot
+   */
+  bool onAny(const EventBits_t mask, handler_t handler, const uint8_t priority = 0U, const uint8_t group = 0U) {
+    return add(mask, std::move(handler), priority, group, false);
+  }
+
+  /**
+   * @brief Register handler called when all bits of the mask are set, must be called before start()
+   *
+   * @param mask event bits within the group
+   * @param handler handler to call
+   * @param priority dispatch priority, handlers with higher value are called first
+   * @param group event group index
+   * @return true if the handler was registered, false if there is no free handler slot
+   */
+  bool onAll(const EventBits_t mask, handler_t handler, const uint8_t priority = 0U, const uint8_t group = 0U) {
+    return add(mask, std::move(handler), priority, group, true);
+  }
+
+  /**
+   * @brief Raise a single event. This function can be called from any context.
+   *
+   * @param event_id event index, less than kMaxEvents
+   */
+  void raise(const uint16_t event_id) {
+    raiseBits(bitOf(event_id), groupOf(event_id));
+  }
+
+  /**
+   * @brief Raise several events of one group. This function can be called from any context.
+   *
+   * @param bits event bits within the group
+   * @param group event group index
+   */
+  void raiseBits(const EventBits_t bits, const uint8_t group = 0U) {
+    assert(group < Groups);
+    assert(0U == (bits & ~kEventsMask));
+    groups_[group].setBits(bits);
+    for (uint8_t i = group; i > 0U; --i) {
+      groups_[i - 1U].setBits(kLinkBit);
+    }
+  }
+
+  /**
+   * @brief Get event group index of the event
+   *
+   * @param event_id event index
+   * @return event group index
+   */
+  static constexpr uint8_t groupOf(const uint16_t event_id) {
+    return static_cast<uint8_t>(event_id / kEventsPerGroup);
+  }
+
+  /**
+   * @brief Get bit value of the event within its group
+   *
+   * @param event_id event index
+   * @return bit value
+   */
+  static constexpr EventBits_t bitOf(const uint16_t event_id) {
+    return static_cast<EventBits_t>(1UL << (event_id % kEventsPerGroup));
+  }
+
+private:
+  static_assert(Groups > 0U, "at least one event group is required");
+
+  /**
+   * @brief Bit signaling pending bits in the next group
+   *
+   */
+  static constexpr EventBits_t kLinkBit{static_cast<EventBits_t>(1UL << (kBitsPerGroup - 1U))};
+
+  /**
+   * @brief Bits available for events in one group
+   *
+   */
+  static constexpr EventBits_t kEventsMask{static_cast<EventBits_t>((1UL << kEventsPerGroup) - 1U)};
+
+  /**
+   * @brief Registered handler
+   *
+   */
+  struct Entry {
+    handler_t handler;
+    EventBits_t mask;
+    uint8_t group;
+    uint8_t priority;
+    bool all;
+  };
+
+  bool add(const EventBits_t mask, handler_t handler, const uint8_t priority, const uint8_t group, const bool all) {
+    assert(nullptr == task_descr_);
+    assert(group < Groups);
+    assert((0U != mask) && (0U == (mask & ~kEventsMask)));
+    if (handlers_count_ >= MaxHandlers) {
+      return false;
+    }
+    /*
+      Keep handlers sorted by priority, handlers of equal priority are called in registration order
+    */
+    size_t index{handlers_count_};
+    while ((index > 0U) && (handlers_[index - 1U].priority < priority)) {
+      handlers_[index] = std::move(handlers_[index - 1U]);
+      --index;
+    }
+    handlers_[index] = Entry{std::move(handler), mask, group, priority, all};
+    ++handlers_count_;
+    wait_masks_[group] |= mask;
+    for (uint8_t i = 0U; i < group; ++i) {
+      wait_masks_[i] |= kLinkBit;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Dispatcher loop
+   *
+   * @param args argument passed to the task
+   */
+  void run(void* args) override {
+    assert(0U != wait_masks_[0]);
+    for (;;) {
+      pending_[0] |= groups_[0].waitForAny(wait_masks_[0], portMAX_DELAY) & wait_masks_[0];
+      for (size_t i = 0U; (i + 1U < Groups) && (0U != (pending_[i] & kLinkBit)); ++i) {
+        pending_[i] &= ~kLinkBit;
+        pending_[i + 1U] |= groups_[i + 1U].clearBits(wait_masks_[i + 1U]) & wait_masks_[i + 1U];
+      }
+
+      std::array<EventBits_t, Groups> dispatched{};
+      for (size_t i = 0U; i < handlers_count_; ++i) {
+        const Entry& entry{handlers_[i]};
+        const EventBits_t hit{pending_[entry.group] & entry.mask};
+        if (entry.all ? (hit == entry.mask) : (0U != hit)) {
+          entry.handler(hit);
+          dispatched[entry.group] |= hit;
+        }
+      }
+      for (size_t i = 0U; i < Groups; ++i) {
+        pending_[i] &= ~dispatched[i];
+      }
+    }
+  }
+
+  /**
+   * @brief Chained event groups
+   *
+   */
+  std::array<EventGroup, Groups> groups_{};
+
+  /**
+   * @brief Bits the dispatcher waits for in every group
+   *
+   */
+  std::array<EventBits_t, Groups> wait_masks_{};
+
+  /**
+   * @brief Bits read from the groups and not dispatched yet
+   *
+   */
+  std::array<EventBits_t, Groups> pending_{};
+
+  /**
+   * @brief Handlers sorted by priority
+   *
+   */
+  std::array<Entry, MaxHandlers> handlers_{};
+
+  /**
+   * @brief Number of registered handlers
+   *
+   */
+  size_t handlers_count_{0U};
+};
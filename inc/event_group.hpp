@@ -4,6 +4,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 #include "config.h"
+#include "trace.hpp"
 
 /**
  * @class EventGroup
@@ -30,7 +31,11 @@ public:
    * @return actual bits were read or zero, if no bits were read from the group
    */
   EventBits_t waitForAny(const EventBits_t bits_to_wait, const uint32_t ticks_to_wait, const bool clear = true) {
-    return xEventGroupWaitBits(handle_, bits_to_wait, clear, pdFALSE, ticks_to_wait);
+    TRACE_START(trace_start);
+    const EventBits_t ret{xEventGroupWaitBits(handle_, bits_to_wait, clear, pdFALSE, ticks_to_wait)};
+    TRACE_EVENT((ret & bits_to_wait) ? TraceEvent::kEventGroupWait : TraceEvent::kEventGroupTimeout, handle_,
+                trace_start, static_cast<uint32_t>(ret & bits_to_wait));
+    return ret;
   }
 
   /**
@@ -42,7 +47,11 @@ public:
    * @return actual bits were read or zero, if no bits were read from the group
    */
   EventBits_t waitForAll(const EventBits_t bits_to_wait, const uint32_t ticks_to_wait, const bool clear = true) {
-    return xEventGroupWaitBits(handle_, bits_to_wait, clear, pdTRUE, ticks_to_wait);
+    TRACE_START(trace_start);
+    const EventBits_t ret{xEventGroupWaitBits(handle_, bits_to_wait, clear, pdTRUE, ticks_to_wait)};
+    TRACE_EVENT(((ret & bits_to_wait) == bits_to_wait) ? TraceEvent::kEventGroupWait : TraceEvent::kEventGroupTimeout,
+                handle_, trace_start, static_cast<uint32_t>(ret & bits_to_wait));
+    return ret;
   }
 
   /**
@@ -53,6 +62,7 @@ public:
    * this function returns (before any other task can clear these bits)
    */
   EventBits_t setBits(const EventBits_t bits_to_set) {
+    TRACE_INSTANT(TraceEvent::kEventGroupSet, handle_, static_cast<uint32_t>(bits_to_set));
     EventBits_t ret;
     const bool isr{IS_IN_ISR()};
     if (isr) {
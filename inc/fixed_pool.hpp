@@ -0,0 +1,395 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include "config.h"
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief Template fixed-block memory pool
+ *
+ * Blocks are kept in a lock-free free list indexed by block number, the list head carries a 16-bit tag
+ * to avoid ABA problem. Local interrupts are masked between reading the head and swapping it, so
+ * the tag could only wrap if the other core did 65536 list operations within those few cycles.
+ * Each core owns a small cache of free blocks which is accessed with local interrupts masked only,
+ * so allocate() and deallocate() can be called from tasks and ISRs on both cores without kernel
+ * critical sections.
+ *
+ * @note up to CacheSize blocks per core can be parked in core caches, so another core can fail
+ * to allocate while less than Count blocks are in use.
+ *
+ * @tparam BlockSize size of one block in bytes
+ * @tparam Count number of blocks in the pool
+ * @tparam CacheSize number of free blocks cached per core, 0 disables core caches
+ */
+template <size_t BlockSize, size_t Count, size_t CacheSize = 4U>
+class FixedPool {
+public:
+  /**
+   * @brief Size of one block in bytes
+   *
+   */
+  static constexpr size_t kBlockSize{BlockSize};
+
+  /**
+   * @brief Number of blocks in the pool
+   *
+   */
+  static constexpr size_t kBlockCount{Count};
+
+  /**
+   * @brief Pool usage statistics
+   *
+   */
+  struct Stats {
+    size_t capacity;
+    size_t used;
+    size_t high_water;
+    size_t failures;
+  };
+
+  /**
+   * @brief Construct a new FixedPool object with all blocks free
+   *
+   */
+  FixedPool() {
+    for (size_t i = 0; i < Count; ++i) {
+      next_[i].store(static_cast<uint16_t>(i + 1U < Count ? i + 1U : kNullIndex), std::memory_order_relaxed);
+    }
+    head_.store(pack(0U, 0U), std::memory_order_release);
+  }
+
+  FixedPool(const FixedPool&) = delete;
+  FixedPool(FixedPool&&) = delete;
+  FixedPool& operator=(const FixedPool&) = delete;
+
+  /**
+   * @brief Allocate one block. This function can be called from any context.
+   *
+   * @return pointer to the block or nullptr if the pool is exhausted
+   */
+  void* allocate() {
+    uint16_t index{popCached()};
+    if (kNullIndex == index) {
+      index = popShared();
+    }
+    if (kNullIndex == index) {
+      failures_.fetch_add(1U, std::memory_order_relaxed);
+      return nullptr;
+    }
+    const size_t used{used_.fetch_add(1U, std::memory_order_relaxed) + 1U};
+    size_t high_water{high_water_.load(std::memory_order_relaxed)};
+    while (used > high_water &&
+           !high_water_.compare_exchange_weak(high_water, used, std::memory_order_relaxed)) {
+    }
+    return &storage_[index * kBlockStride];
+  }
+
+  /**
+   * @brief Return a block to the pool. This function can be called from any context.
+   *
+   * @param block pointer to any byte inside of the block previously returned by allocate()
+   */
+  void deallocate(void* block) {
+    if (nullptr == block) {
+      return;
+    }
+    assert(owns(block));
+    const uint16_t index{
+      static_cast<uint16_t>((static_cast<uint8_t*>(block) - storage_) / static_cast<ptrdiff_t>(kBlockStride))};
+    used_.fetch_sub(1U, std::memory_order_relaxed);
+    if (!pushCached(index)) {
+      pushShared(index);
+    }
+  }
+
+  /**
+   * @brief Allocate a block and construct an object in it
+   *
+   * @tparam T object type
+   * @param args constructor arguments
+   * @return pointer to the constructed object or nullptr if the pool is exhausted
+   */
+  template <typename T, typename... Args>
+  T* create(Args&&... args) {
+    static_assert(sizeof(T) <= BlockSize, "object does not fit into the pool block");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "object alignment is not supported");
+    void* block{allocate()};
+    return (nullptr != block) ? new (block) T(std::forward<Args>(args)...) : nullptr;
+  }
+
+  /**
+   * @brief Destroy an object created with create() and return its block to the pool
+   *
+   * @tparam T object type
+   * @param object pointer to the object, may point to a base class subobject with virtual destructor
+   */
+  template <typename T>
+  void destroy(T* object) {
+    if (nullptr == object) {
+      return;
+    }
+    object->~T();
+    deallocate(object);
+  }
+
+  /**
+   * @brief Check if the pointer belongs to the pool storage
+   *
+   * @param ptr pointer to check
+   * @return true if the pointer is inside of the pool storage, otherwise false
+   */
+  bool owns(const void* ptr) const {
+    const uint8_t* byte{static_cast<const uint8_t*>(ptr)};
+    return (byte >= storage_) && (byte < storage_ + sizeof(storage_));
+  }
+
+  /**
+   * @brief Get current usage statistics
+   *
+   * @return usage statistics snapshot
+   */
+  Stats stats() const {
+    return Stats{Count, used_.load(std::memory_order_relaxed), high_water_.load(std::memory_order_relaxed),
+                 failures_.load(std::memory_order_relaxed)};
+  }
+
+  /**
+   * @brief Get number of blocks currently in use
+   *
+   * @return number of allocated blocks
+   */
+  size_t used() const {
+    return used_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Get number of blocks available for allocation, including blocks cached by cores
+   *
+   * @return number of free blocks
+   */
+  size_t available() const {
+    return Count - used();
+  }
+
+private:
+  static_assert(Count > 0U, "pool must contain at least one block");
+  static_assert(Count < 0xFFFFU, "too many blocks in the pool");
+
+  /**
+   * @brief Index value used as a list terminator
+   *
+   */
+  static constexpr uint16_t kNullIndex{0xFFFFU};
+
+  /**
+   * @brief Distance between neighbour blocks, keeps every block maximally aligned
+   *
+   */
+  static constexpr size_t kBlockStride{(BlockSize + alignof(std::max_align_t) - 1U) &
+                                       ~(alignof(std::max_align_t) - 1U)};
+
+  /**
+   * @brief Per core cache of free blocks, only touched by its own core with interrupts masked
+   *
+   */
+  struct alignas(CACHE_LINE_SIZE) CoreCache {
+    std::array<uint16_t, CacheSize> blocks{};
+    size_t count{0U};
+  };
+
+  static constexpr uint32_t pack(const uint16_t index, const uint16_t tag) {
+    return (static_cast<uint32_t>(tag) << 16U) | index;
+  }
+
+  static constexpr uint16_t indexOf(const uint32_t head) {
+    return static_cast<uint16_t>(head & 0xFFFFU);
+  }
+
+  static constexpr uint16_t tagOf(const uint32_t head) {
+    return static_cast<uint16_t>(head >> 16U);
+  }
+
+  /**
+   * @brief Take a block from the current core cache
+   *
+   * @return block index or kNullIndex if the cache is empty
+   */
+  uint16_t popCached() {
+    uint16_t index{kNullIndex};
+    if (CacheSize > 0U) {
+      const UBaseType_t state{portSET_INTERRUPT_MASK_FROM_ISR()};
+      CoreCache& cache{caches_[CURRENT_CORE_ID()]};
+      if (cache.count > 0U) {
+        index = cache.blocks[--cache.count];
+      }
+      portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    }
+    return index;
+  }
+
+  /**
+   * @brief Put a block into the current core cache
+   *
+   * @param index block index
+   * @return true if the block was cached, false if the cache is full
+   */
+  bool pushCached(const uint16_t index) {
+    bool ret{false};
+    if (CacheSize > 0U) {
+      const UBaseType_t state{portSET_INTERRUPT_MASK_FROM_ISR()};
+      CoreCache& cache{caches_[CURRENT_CORE_ID()]};
+      if (cache.count < CacheSize) {
+        cache.blocks[cache.count++] = index;
+        ret = true;
+      }
+      portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Take a block from the shared lock-free list
+   *
+   * @return block index or kNullIndex if the list is empty
+   */
+  uint16_t popShared() {
+    uint16_t ret{kNullIndex};
+    const UBaseType_t state{portSET_INTERRUPT_MASK_FROM_ISR()};
+    uint32_t head{head_.load(std::memory_order_acquire)};
+    while (kNullIndex != indexOf(head)) {
+      const uint16_t index{indexOf(head)};
+      const uint32_t next{pack(next_[index].load(std::memory_order_relaxed), tagOf(head) + 1U)};
+      if (head_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        ret = index;
+        break;
+      }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+    return ret;
+  }
+
+  /**
+   * @brief Return a block to the shared lock-free list
+   *
+   * @param index block index
+   */
+  void pushShared(const uint16_t index) {
+    const UBaseType_t state{portSET_INTERRUPT_MASK_FROM_ISR()};
+    uint32_t head{head_.load(std::memory_order_relaxed)};
+    do {
+      next_[index].store(indexOf(head), std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head, pack(index, tagOf(head) + 1U), std::memory_order_release,
+                                          std::memory_order_relaxed));
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+  }
+
+  /**
+   * @brief Blocks storage
+   *
+   */
+  alignas(std::max_align_t) uint8_t storage_[Count * kBlockStride];
+
+  /**
+   * @brief Free list links, one per block
+   *
+   */
+  std::atomic<uint16_t> next_[Count];
+
+  /**
+   * @brief Tagged head of the shared free list
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> head_{pack(kNullIndex, 0U)};
+
+  /**
+   * @brief Free block caches, one per core
+   *
+   */
+  CoreCache caches_[portNUM_PROCESSORS]{};
+
+  /**
+   * @brief Usage counters
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> used_{0U};
+  std::atomic<size_t> high_water_{0U};
+  std::atomic<size_t> failures_{0U};
+};
+
+/**
+ * @brief STL-compatible allocator adapter for FixedPool
+ *
+ * Only single object allocations are supported, which is enough for node based containers
+ * (std::list, std::map, std::set) and std::allocate_shared. An array request or an exhausted pool
+ * throws std::bad_alloc, or aborts when exceptions are disabled, since containers cannot handle nullptr.
+ *
+ * @tparam T type of allocated objects
+ * @tparam Pool FixedPool type
+ */
+template <typename T, typename Pool>
+class FixedPoolAllocator {
+public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = FixedPoolAllocator<U, Pool>;
+  };
+
+  /**
+   * @brief Construct a new FixedPoolAllocator object
+   *
+   * @param pool pool to allocate from
+   */
+  explicit FixedPoolAllocator(Pool& pool) noexcept : pool_{&pool} {
+  }
+
+  template <typename U>
+  FixedPoolAllocator(const FixedPoolAllocator<U, Pool>& other) noexcept : pool_{other.pool()} {
+  }
+
+  T* allocate(const size_t n) {
+    static_assert(sizeof(T) <= Pool::kBlockSize, "object does not fit into the pool block");
+    void* block{(1U == n) ? pool_->allocate() : nullptr};
+    if (nullptr == block) {
+#if __cpp_exceptions
+      throw std::bad_alloc();
+#else
+      abort();
+#endif // __cpp_exceptions
+    }
+    return static_cast<T*>(block);
+  }
+
+  void deallocate(T* ptr, const size_t n) noexcept {
+    pool_->deallocate(ptr);
+  }
+
+  Pool* pool() const noexcept {
+    return pool_;
+  }
+
+  template <typename U>
+  bool operator==(const FixedPoolAllocator<U, Pool>& other) const noexcept {
+    return pool_ == other.pool();
+  }
+
+  template <typename U>
+  bool operator!=(const FixedPoolAllocator<U, Pool>& other) const noexcept {
+    return pool_ != other.pool();
+  }
+
+private:
+  /**
+   * @brief Pool to allocate from
+   *
+   */
+  Pool* pool_;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "wait_list.hpp"
+
+/**
+ * @class Latch
+ *
+ * @brief Single-use counter which releases waiting tasks once it is counted down to zero
+ *
+ * Waiting tasks spin for a short time and then block on their task notification at
+ * WaitList::kNotifyIndex, notifications on index 0 are not touched.
+ */
+class Latch {
+public:
+  /**
+   * @brief Default number of polling iterations before blocking
+   *
+   */
+  static constexpr uint32_t kDefaultSpinIterations{(portNUM_PROCESSORS > 1) ? 256U : 0U};
+
+  /**
+   * @brief Construct a new Latch object
+   *
+   * @param count initial counter value
+   * @param spin_iterations number of polling iterations before blocking
+   */
+  explicit Latch(const size_t count, const uint32_t spin_iterations = kDefaultSpinIterations)
+  : count_{count}, spin_iterations_{spin_iterations} {
+  }
+
+  Latch(const Latch&) = delete;
+  Latch& operator=(const Latch&) = delete;
+
+  /**
+   * @brief Decrease the counter, releases waiting tasks when it reaches zero.
+   * This function can be called from any context.
+   *
+   * @param n value to subtract
+   */
+  void countDown(const size_t n = 1U) {
+    const size_t previous{count_.fetch_sub(n, std::memory_order_acq_rel)};
+    assert(previous >= n);
+    if (previous == n) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      waiters_.notifyAll();
+    }
+  }
+
+  /**
+   * @brief Check if the counter has reached zero
+   *
+   * @return true if the counter is zero, otherwise false
+   */
+  bool tryWait() const {
+    return 0U == count_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Wait until the counter reaches zero
+   *
+   */
+  void wait() {
+    waitTicks(portMAX_DELAY);
+  }
+
+  /**
+   * @brief Wait until the counter reaches zero or the timeout expires
+   *
+   * @param timeout_ms maximum timeout specified in ms
+   * @return true if the counter is zero, false on timeout
+   */
+  bool waitFor(const uint32_t timeout_ms) {
+    return waitTicks(pdMS_TO_TICKS(timeout_ms));
+  }
+
+  /**
+   * @brief Decrease the counter and wait until it reaches zero
+   *
+   * @param n value to subtract
+   */
+  void arriveAndWait(const size_t n = 1U) {
+    countDown(n);
+    wait();
+  }
+
+private:
+  /**
+   * @brief Spin for a while, then block until the counter reaches zero or the timeout expires
+   *
+   * @param ticks maximum timeout specified in ticks
+   * @return true if the counter is zero, false on timeout
+   */
+  bool waitTicks(TickType_t ticks) {
+    assert(!IS_IN_ISR());
+    for (uint32_t i = 0U; (i < spin_iterations_) && !tryWait(); ++i) {
+    }
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    while (!tryWait()) {
+      if (pdFALSE != xTaskCheckForTimeOut(&timeout, &ticks)) {
+        return tryWait();
+      }
+      WaitList::Waiter waiter;
+      waiters_.add(waiter);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (tryWait()) {
+        waiters_.cancel(waiter);
+        break;
+      }
+      waiters_.wait(waiter, ticks);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Counter value
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> count_;
+
+  /**
+   * @brief Number of polling iterations before blocking
+   *
+   */
+  const uint32_t spin_iterations_;
+
+  /**
+   * @brief Blocked tasks
+   *
+   */
+  WaitList waiters_;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include "task.hpp"
+
+/**
+ * @class LoadBalancer
+ *
+ * @brief Task periodically measuring per-core utilization and moving automatically placed tasks
+ * (created with Task::kCoreAuto) from an overloaded core to the least loaded one
+ *
+ * A task is moved only after the imbalance has exceeded the threshold for several consecutive
+ * periods, and only a task whose own load is at most half of the imbalance, so tasks do not
+ * bounce between cores. Without configUSE_CORE_AFFINITY a task moves when its run() returns on
+ * Task::migrationRequested(), tasks with a pending move are not chosen again. Utilization requires
+ * configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY, without them tasks are placed by
+ * the number of tasks per core only.
+ */
+class LoadBalancer : public Task {
+public:
+  /**
+   * @brief Maximum number of automatically placed tasks
+   *
+   */
+  static constexpr size_t kMaxTasks{32U};
+
+  /**
+   * @brief Construct a new LoadBalancer object
+   *
+   * @param period_ms measurement period in ms
+   * @param threshold_percent minimal utilization difference between cores to move a task
+   * @param hysteresis number of consecutive periods the threshold has to be exceeded
+   * @param task_name task name
+   * @param stack_size task stack size
+   * @param priority task priority
+   */
+  explicit LoadBalancer(const uint32_t period_ms = 1000U, const uint8_t threshold_percent = 20U,
+                        const uint8_t hysteresis = 3U, const std::string& task_name = "LoadBalancer",
+                        const uint16_t stack_size = configMINIMAL_STACK_SIZE * 2U,
+                        const uint8_t priority = kTaskDefaultPriority);
+
+  /**
+   * @brief Measure utilization of cores and automatically placed tasks since the previous call
+   *
+   */
+  static void sample();
+
+  /**
+   * @brief Get core utilization measured by the last sample()
+   *
+   * @param core_id core id
+   * @return utilization in percent
+   */
+  static uint8_t utilization(const BaseType_t core_id);
+
+  /**
+   * @brief Get the core for a new task: the least utilized one, or the one with fewer
+   * automatically placed tasks when utilization is unknown or equal
+   *
+   * @return core id
+   */
+  static BaseType_t leastLoadedCore();
+
+  /**
+   * @brief Register automatically placed task, called by Task::start()
+   *
+   * @param task task object
+   * @return true if the task is registered, false if the registry is full
+   */
+  static bool attach(Task& task);
+
+  /**
+   * @brief Unregister automatically placed task, called by Task::stop()
+   *
+   * @param task task object
+   */
+  static void detach(Task& task);
+
+private:
+  /**
+   * @brief Balancer loop
+   *
+   * @param args argument passed to the task
+   */
+  void run(void* args) override;
+
+  /**
+   * @brief Release entries pinned by an interrupted rebalance(), so detach() does not wait forever
+   *
+   */
+  void onStop() override;
+
+  /**
+   * @brief Move one task if the imbalance persists long enough
+   *
+   */
+  void rebalance();
+
+  /**
+   * @brief Measurement period in ms
+   *
+   */
+  const uint32_t period_ms_;
+
+  /**
+   * @brief Minimal utilization difference to move a task
+   *
+   */
+  const uint8_t threshold_percent_;
+
+  /**
+   * @brief Number of consecutive periods the threshold has to be exceeded
+   *
+   */
+  const uint8_t hysteresis_;
+
+  /**
+   * @brief Number of consecutive periods the threshold is exceeded
+   *
+   */
+  uint8_t streak_{0U};
+};
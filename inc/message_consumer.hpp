@@ -10,8 +10,9 @@
  *
  * @tparam T type of messages in queue
  * @tparam queue_size queue length
+ * @tparam QueueType queue template with Queue interface, e.g. MpmcQueue
  */
-template <typename T, size_t queue_size = DEFAULT_RX_QUEUE_SIZE>
+template <typename T, size_t queue_size = DEFAULT_RX_QUEUE_SIZE, template <typename, size_t> class QueueType = Queue>
 class MessageConsumer {
 public:
   /**
@@ -46,7 +47,7 @@ public:
    * Get incomming queue object
    * @return pointer to incomming messages queue object
    */
-  Queue<T, queue_size>* incommingQueue() {
+  QueueType<T, queue_size>* incommingQueue() {
     return &queue_;
   }
 
@@ -54,5 +55,5 @@ private:
   /**
    * Internal queue object
    */
-  Queue<T, queue_size> queue_{};
+  QueueType<T, queue_size> queue_{};
 };
\ No newline at end of file
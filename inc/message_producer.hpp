@@ -10,22 +10,23 @@
  *
  * @tparam T type of messages in queue
  * @tparam queue_size queue length
+ * @tparam QueueType queue template with Queue interface, e.g. MpmcQueue
  */
-template <typename T, size_t queue_size = DEFAULT_TX_QUEUE_SIZE>
+template <typename T, size_t queue_size = DEFAULT_TX_QUEUE_SIZE, template <typename, size_t> class QueueType = Queue>
 class MessageProducer {
 public:
   /**
    * Constructs new MessageProducer object
    * @param queue outcoming queue
    */
-  explicit MessageProducer(Queue<T, queue_size>* queue = nullptr) : tx_queue_(queue) {
+  explicit MessageProducer(QueueType<T, queue_size>* queue = nullptr) : tx_queue_(queue) {
   }
 
   /**
    * Set outcoming queue
    * @param queue desired queue object
    */
-  void setOutcomingQueue(Queue<T, queue_size>* queue) {
+  void setOutcomingQueue(QueueType<T, queue_size>* queue) {
     tx_queue_ = queue;
   }
 
@@ -33,7 +34,7 @@ public:
    * Get outcoming queue
    * @return outcoming queue bject pointer
    */
-  Queue<T, queue_size>* getOutcomingQueue() const {
+  QueueType<T, queue_size>* getOutcomingQueue() const {
     return tx_queue_;
   }
 
@@ -55,5 +56,5 @@ protected:
   /**
    * @brief Pointer to outcoming queue object
    */
-  Queue<T, queue_size>* tx_queue_{};
+  QueueType<T, queue_size>* tx_queue_{};
 };
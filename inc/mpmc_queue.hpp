@@ -0,0 +1,276 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "wait_list.hpp"
+
+/**
+ * @brief Template lock-free bounded multi-producer multi-consumer queue
+ *
+ * Every slot carries a sequence number which tells producers and consumers whether the slot
+ * is free or holds a message, so enqueueBack() and receive() take no lock and do not enter
+ * kernel critical sections while the queue is neither full nor empty. Only a task that has
+ * to block registers itself in a WaitList and sleeps on the library notification index.
+ * The interface follows Queue, so the queue can be used with MessageProducer and MessageConsumer.
+ *
+ * The number of slots is length rounded up to a power of two. For other lengths the number of
+ * messages is limited by an additional atomic counter, which costs one more atomic operation
+ * per message, so power of two lengths are preferable.
+ *
+ * @tparam T type of messages in queue
+ * @tparam length queue length
+ */
+template <typename T, size_t length>
+class MpmcQueue {
+public:
+  /**
+   * @brief Construct a new MpmcQueue object
+   *
+   */
+  MpmcQueue() {
+    for (size_t i = 0U; i < kSlots; ++i) {
+      cells_[i].sequence.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  /**
+   * @brief Add a message at the end of the queue
+   *
+   * @param msg message object
+   * @param timeout_ms max ms to wait for, ignored in ISR
+   * @return true if the message was enqueued
+   * @return false otherwise
+   */
+  bool enqueueBack(const T& msg, const uint32_t timeout_ms = 0u) {
+    bool ret{tryPush(msg)};
+    if (!ret && (0U != timeout_ms) && !IS_IN_ISR()) {
+      ret = blockingCall(not_full_, timeout_ms, [this, &msg]() { return tryPush(msg); });
+    }
+    if (ret) {
+      wakeOne(not_empty_);
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Read first message from the queue, pops the message out from the queue
+   *
+   * @param out object to read into
+   * @param timeout_ms max ms to wait for, ignored in ISR
+   * @return true if read operation was successfull
+   * @return false otherwise
+   */
+  bool receive(T& out, const uint32_t timeout_ms = 0) {
+    bool ret{tryPop(out)};
+    if (!ret && (0U != timeout_ms) && !IS_IN_ISR()) {
+      ret = blockingCall(not_empty_, timeout_ms, [this, &out]() { return tryPop(out); });
+    }
+    if (ret) {
+      wakeOne(not_full_);
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Get current number of messages in the queue
+   *
+   * @return current number of messages in the queue, approximate while producers or consumers are active
+   */
+  size_t size() const {
+    const uint32_t head{dequeue_pos_.load(std::memory_order_relaxed)};
+    const uint32_t tail{enqueue_pos_.load(std::memory_order_relaxed)};
+    const int32_t count{static_cast<int32_t>(tail - head)};
+    if (count < 0) {
+      return 0U;
+    }
+    return (static_cast<size_t>(count) > length) ? length : static_cast<size_t>(count);
+  }
+
+  /**
+   * @brief Get number of available spaces in the queue for new messages
+   *
+   * @return number of available spaces in the queue for new messages
+   */
+  size_t available() const {
+    return length - size();
+  }
+
+private:
+  static_assert((length > 0U) && (length <= 0x80000000U), "queue length must be within 1..2^31");
+
+  static constexpr size_t slots() {
+    size_t count{2U};
+    while (count < length) {
+      count <<= 1U;
+    }
+    return count;
+  }
+
+  static constexpr size_t kSlots{slots()};
+  static constexpr uint32_t kMask{kSlots - 1U};
+  static constexpr bool kCounted{kSlots != length};
+
+  /**
+   * @brief Queue slot, on its own cache line
+   *
+   */
+  struct alignas(CACHE_LINE_SIZE) Cell {
+    std::atomic<uint32_t> sequence{0U};
+    T value{};
+  };
+
+  /**
+   * @brief Reserve space for one message when length is not a power of two
+   *
+   * @return true if the queue holds less than length messages
+   */
+  bool reserve() {
+    if constexpr (kCounted) {
+      size_t count{count_.load(std::memory_order_relaxed)};
+      do {
+        if (count >= length) {
+          return false;
+        }
+      } while (!count_.compare_exchange_weak(count, count + 1U, std::memory_order_acq_rel));
+    }
+    return true;
+  }
+
+  void unreserve() {
+    if constexpr (kCounted) {
+      count_.fetch_sub(1U, std::memory_order_acq_rel);
+    }
+  }
+
+  bool tryPush(const T& msg) {
+    if (!reserve()) {
+      return false;
+    }
+    uint32_t pos{enqueue_pos_.load(std::memory_order_relaxed)};
+    Cell* cell{nullptr};
+    for (;;) {
+      cell = &cells_[pos & kMask];
+      const int32_t diff{static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - pos)};
+      if (0 == diff) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        unreserve();
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = msg;
+    cell->sequence.store(pos + 1U, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T& out) {
+    uint32_t pos{dequeue_pos_.load(std::memory_order_relaxed)};
+    Cell* cell{nullptr};
+    for (;;) {
+      cell = &cells_[pos & kMask];
+      const int32_t diff{static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - (pos + 1U))};
+      if (0 == diff) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    out = cell->value;
+    cell->sequence.store(pos + kSlots, std::memory_order_release);
+    unreserve();
+    return true;
+  }
+
+  /**
+   * @brief Retry the operation until it succeeds, sleeping in the wait list between attempts
+   *
+   * @param waiters wait list to sleep in
+   * @param timeout_ms timeout in ms
+   * @param attempt non-blocking operation
+   * @return true if the operation succeeded, false on timeout
+   */
+  template <typename Attempt>
+  bool blockingCall(WaitList& waiters, const uint32_t timeout_ms, Attempt attempt) {
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    TickType_t ticks{pdMS_TO_TICKS(timeout_ms)};
+    for (;;) {
+      WaitList::Waiter waiter;
+      waiters.add(waiter);
+      /*
+        Re-check after registration, the other side checks the wait list after its operation
+      */
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (attempt()) {
+        waiters.cancel(waiter);
+        return true;
+      }
+      waiters.wait(waiter, ticks);
+      if (attempt()) {
+        return true;
+      }
+      if (pdFALSE != xTaskCheckForTimeOut(&timeout, &ticks)) {
+        return false;
+      }
+    }
+  }
+
+  void wakeOne(WaitList& waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiters.empty()) {
+      waiters.notifyOne();
+    }
+  }
+
+  /**
+   * @brief Message slots
+   *
+   */
+  std::array<Cell, kSlots> cells_{};
+
+  /**
+   * @brief Producers position
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> enqueue_pos_{0U};
+
+  /**
+   * @brief Consumers position
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> dequeue_pos_{0U};
+
+  /**
+   * @brief Number of messages and reserved slots, used only when length is not a power of two
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> count_{0U};
+
+  /**
+   * @brief Tasks waiting for a message
+   *
+   */
+  WaitList not_empty_;
+
+  /**
+   * @brief Tasks waiting for free space
+   *
+   */
+  WaitList not_full_;
+};
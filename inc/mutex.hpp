@@ -4,6 +4,7 @@
 #include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "trace.hpp"
 
 /**
  * @class Mutex
@@ -36,7 +37,10 @@ public:
    */
   bool tryLock(const TickType_t delay) {
     assert(!IS_IN_ISR());
-    return (xSemaphoreTakeRecursive(handle_, delay) != pdFALSE);
+    TRACE_START(trace_start);
+    const bool ret{xSemaphoreTakeRecursive(handle_, delay) != pdFALSE};
+    TRACE_EVENT(ret ? TraceEvent::kMutexAcquire : TraceEvent::kMutexTimeout, handle_, trace_start, 0U);
+    return ret;
   }
 
   /**
@@ -54,6 +58,7 @@ public:
    * @return true if it was unlocked, otherwise false
    */
   bool tryUnlock() {
+    TRACE_INSTANT(TraceEvent::kMutexRelease, handle_, 0U);
     return (xSemaphoreGiveRecursive(handle_) != pdFALSE);
   }
 
@@ -31,6 +31,15 @@ public:
     mutex_ref_.unlock();
   }
 
+  /**
+   * @brief Get the locked mutex
+   *
+   * @return mutex object refference
+   */
+  Mutex& mutex() {
+    return mutex_ref_;
+  }
+
 private:
   /**
    * @brief Mutex object refference
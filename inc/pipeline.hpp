@@ -0,0 +1,600 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "config.h"
+#include "esp_cpu.h"
+#include "queue.hpp"
+#include "task.hpp"
+
+#define DEFAULT_PIPELINE_QUEUE_SIZE 8U
+#define DEFAULT_PIPELINE_STACK_SIZE configMINIMAL_STACK_SIZE
+#define DEFAULT_PIPELINE_TIMEOUT 0xFFFFFFFFU
+
+/**
+ * @brief Message passed between pipeline stages
+ *
+ * @tparam T type of payload
+ */
+template <typename T>
+struct PipelineItem {
+  T value;
+  uint32_t enqueued_at;
+  bool stop;
+};
+
+/**
+ * @brief Statistics of one pipeline stage, cycle sums wrap around
+ *
+ * busy_cycles is the time spent in process(), blocked_cycles the time spent passing results to
+ * the next stage including waiting for space in its queue, latency_cycles the time from
+ * enqueueing a message into the stage queue until it is processed.
+ */
+struct PipelineStageStats {
+  uint32_t processed;
+  uint32_t dropped;
+  uint32_t busy_cycles;
+  uint32_t max_busy_cycles;
+  uint32_t blocked_cycles;
+  uint32_t max_blocked_cycles;
+  uint32_t latency_cycles;
+  uint32_t max_latency_cycles;
+};
+
+/**
+ * @brief Queue length in front of the stage, a stage can override it with static queue_depth member
+ *
+ * @tparam Stage stage type
+ */
+template <typename Stage, typename = void>
+struct PipelineQueueDepth {
+  static constexpr size_t value{DEFAULT_PIPELINE_QUEUE_SIZE};
+};
+
+template <typename Stage>
+struct PipelineQueueDepth<Stage, std::void_t<decltype(Stage::queue_depth)>> {
+  static constexpr size_t value{Stage::queue_depth};
+};
+
+/**
+ * @brief Stack size of the stage task, a stage can override it with static stack_size member
+ *
+ * @tparam Stage stage type
+ */
+template <typename Stage, typename = void>
+struct PipelineStackSize {
+  static constexpr size_t value{DEFAULT_PIPELINE_STACK_SIZE};
+};
+
+template <typename Stage>
+struct PipelineStackSize<Stage, std::void_t<decltype(Stage::stack_size)>> {
+  static constexpr size_t value{Stage::stack_size};
+};
+
+/**
+ * @brief Check that output type of every stage matches input type of the next one
+ *
+ * @tparam Stages stage types
+ */
+template <typename... Stages>
+struct PipelineChain;
+
+template <typename Last>
+struct PipelineChain<Last> : std::true_type {};
+
+template <typename First, typename Second, typename... Rest>
+struct PipelineChain<First, Second, Rest...>
+: std::integral_constant<bool, std::is_same<typename First::output_type, typename Second::input_type>::value &&
+                                 PipelineChain<Second, Rest...>::value> {};
+
+template <typename First, typename... Rest>
+class Fuse;
+
+template <typename... Rest>
+struct FuseTail {
+  using type = Fuse<Rest...>;
+};
+
+template <typename Last>
+struct FuseTail<Last> {
+  using type = Last;
+};
+
+/**
+ * @brief Template stage running several stages one after another on the same task,
+ * which avoids a queue hop and a context switch between them
+ *
+ * @tparam First first stage type
+ * @tparam Rest other stage types
+ */
+template <typename First, typename... Rest>
+class Fuse {
+public:
+  using tail_t = typename FuseTail<Rest...>::type;
+  using input_type = typename First::input_type;
+  using output_type = typename tail_t::output_type;
+
+  static_assert(sizeof...(Rest) > 0U, "at least two stages are required to fuse");
+  static_assert(PipelineChain<First, tail_t>::value, "stage output type does not match next stage input type");
+
+  /**
+   * @brief Stack size of the task running fused stages, the largest one of the stages
+   *
+   */
+  static constexpr size_t stack_size{(PipelineStackSize<First>::value > PipelineStackSize<tail_t>::value)
+                                         ? PipelineStackSize<First>::value
+                                         : PipelineStackSize<tail_t>::value};
+
+  /**
+   * @brief Process the message by all fused stages
+   *
+   * @param in input message
+   * @param out output message, omitted when output_type is void
+   * @return true if the message passed all stages, false if some stage dropped it
+   */
+  template <typename... Out>
+  bool process(const input_type& in, Out&... out) {
+    typename First::output_type middle{};
+    return first_.process(in, middle) && tail_.process(middle, out...);
+  }
+
+  First& first() {
+    return first_;
+  }
+
+  tail_t& tail() {
+    return tail_;
+  }
+
+private:
+  First first_{};
+  tail_t tail_{};
+};
+
+/**
+ * @brief Template pipeline of stages connected with queues, every stage runs on its own task
+ *
+ * A stage is a class with input_type and output_type members and
+ * bool process(const input_type& in, output_type& out) method, or
+ * bool process(const input_type& in) when output_type is void (only allowed for the last stage).
+ * process() returns false to drop the message. Stage types are checked at compile time, stages
+ * can be merged onto one task with Fuse<>.
+ *
+ * Full queues block upstream stages and finally push(), shutdown() passes a stop marker through
+ * all stages after the messages already queued. Messages are copied by the kernel queues, so they
+ * have to be trivially copyable.
+ *
+ * Queue storage and stage task stacks are kept inside of the Pipeline object, so nothing is taken
+ * from the heap and the object should be placed in static memory rather than on a task stack.
+ * Finished stage tasks stay parked until the Pipeline is destroyed, so their storage is released
+ * together with the object and not later by the idle task.
+ *
+ * @tparam Stages stage types
+ */
+template <typename... Stages>
+class Pipeline {
+public:
+  static constexpr size_t kStages{sizeof...(Stages)};
+
+  using stages_t = std::tuple<Stages...>;
+  using input_type = typename std::tuple_element<0, stages_t>::type::input_type;
+  using output_type = typename std::tuple_element<kStages - 1U, stages_t>::type::output_type;
+
+  static_assert(kStages > 0U, "pipeline requires at least one stage");
+  static_assert(PipelineChain<Stages...>::value, "stage output type does not match next stage input type");
+
+  /**
+   * @brief Construct a new Pipeline object
+   *
+   * @param name name prefix of stage tasks
+   * @param priority priority of every stage task
+   * @param core_id core id of every stage task, cycle based latency assumes stages share the core
+   */
+  explicit Pipeline(const std::string& name = "Pipeline", const uint8_t priority = Task::kTaskDefaultPriority,
+                    const BaseType_t core_id = 0)
+  : name_{name}, priority_{priority}, core_id_{core_id} {
+  }
+
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator=(const Pipeline&) = delete;
+
+  /**
+   * @brief Destroy the Pipeline object, shuts the started pipeline down and waits for all stage tasks
+   * to park before their stacks and control blocks are released
+   *
+   */
+  ~Pipeline() {
+    if (!started_) {
+      return;
+    }
+    shutdown();
+    join();
+    waitParked(std::index_sequence_for<Stages...>{});
+  }
+
+  /**
+   * @brief Start all stage tasks
+   *
+   */
+  void start() {
+    started_ = true;
+    startTasks(std::index_sequence_for<Stages...>{});
+  }
+
+  /**
+   * @brief Push a message into the first stage
+   *
+   * @param value message
+   * @param timeout_ms timeout in ms to wait for space in the first queue
+   * @return true if the message was enqueued, false on timeout or after shutdown()
+   */
+  bool push(const input_type& value, const uint32_t timeout_ms = DEFAULT_PIPELINE_TIMEOUT) {
+    /*
+      Pairs with shutdown(): either this sees the pipeline closed or shutdown() waits for this push
+    */
+    pushing_.fetch_add(1U, std::memory_order_seq_cst);
+    bool ret{false};
+    if (!closed_.load(std::memory_order_seq_cst)) {
+      const PipelineItem<input_type> item{value, CPU_CYCLE_COUNT(), false};
+      ret = std::get<0>(queues_).enqueueBack(item, timeout_ms);
+    }
+    pushing_.fetch_sub(1U, std::memory_order_release);
+    return ret;
+  }
+
+  /**
+   * @brief Pop a message produced by the last stage
+   *
+   * @param out object to read into
+   * @param timeout_ms timeout in ms
+   * @return true if a message was read, false on timeout or when the pipeline was shut down
+   */
+  template <typename U = output_type>
+  bool pop(U& out, const uint32_t timeout_ms = DEFAULT_PIPELINE_TIMEOUT) {
+    static_assert(!std::is_void<output_type>::value, "last stage produces no output");
+    PipelineItem<U> item;
+    if (!output_.receive(item, timeout_ms)) {
+      return false;
+    }
+    if (item.stop) {
+      /*
+        Keep the stop marker for subsequent calls
+      */
+      output_.enqueueFront(item);
+      return false;
+    }
+    out = item.value;
+    return true;
+  }
+
+  /**
+   * @brief Stop accepting messages and let every stage exit after draining its queue
+   *
+   */
+  void shutdown() {
+    if (closed_.exchange(true, std::memory_order_seq_cst)) {
+      return;
+    }
+    /*
+      The stop marker has to be the last message, let pushes which missed the flag finish first
+    */
+    while (0U != pushing_.load(std::memory_order_acquire)) {
+      vTaskDelay(1);
+    }
+    PipelineItem<input_type> item{};
+    item.stop = true;
+    while (!std::get<0>(queues_).enqueueBack(item, DEFAULT_PIPELINE_TIMEOUT)) {
+    }
+  }
+
+  /**
+   * @brief Wait for all stage tasks to exit after shutdown()
+   *
+   * @param timeout_ms timeout in ms for every stage
+   * @return true if all stages exited, otherwise false
+   */
+  bool join(const uint32_t timeout_ms = portMAX_DELAY) {
+    return joinTasks(std::index_sequence_for<Stages...>{}, timeout_ms);
+  }
+
+  /**
+   * @brief Get the stage object
+   *
+   * @tparam I stage index
+   * @return stage object refference
+   */
+  template <size_t I>
+  typename std::tuple_element<I, stages_t>::type& stage() {
+    return std::get<I>(stages_);
+  }
+
+  /**
+   * @brief Get statistics of the stage
+   *
+   * @param index stage index
+   * @return statistics snapshot
+   */
+  PipelineStageStats stats(const size_t index) const {
+    assert(index < kStages);
+    const Counters& counters{counters_[index]};
+    return PipelineStageStats{counters.processed.load(std::memory_order_relaxed),
+                              counters.dropped.load(std::memory_order_relaxed),
+                              counters.busy_cycles.load(std::memory_order_relaxed),
+                              counters.max_busy_cycles.load(std::memory_order_relaxed),
+                              counters.blocked_cycles.load(std::memory_order_relaxed),
+                              counters.max_blocked_cycles.load(std::memory_order_relaxed),
+                              counters.latency_cycles.load(std::memory_order_relaxed),
+                              counters.max_latency_cycles.load(std::memory_order_relaxed)};
+  }
+
+private:
+  /**
+   * @brief Placeholder for the output queue of a pipeline ending with a sink stage
+   *
+   */
+  struct NoQueue {};
+
+  template <typename T, bool = std::is_void<T>::value>
+  struct OutputQueue {
+    using type = StaticQueue<PipelineItem<T>, DEFAULT_PIPELINE_QUEUE_SIZE>;
+  };
+
+  template <typename T>
+  struct OutputQueue<T, true> {
+    using type = NoQueue;
+  };
+
+  /**
+   * @brief Statistics counters, written by the stage task only
+   *
+   */
+  struct Counters {
+    std::atomic<uint32_t> processed{0U};
+    std::atomic<uint32_t> dropped{0U};
+    std::atomic<uint32_t> busy_cycles{0U};
+    std::atomic<uint32_t> max_busy_cycles{0U};
+    std::atomic<uint32_t> blocked_cycles{0U};
+    std::atomic<uint32_t> max_blocked_cycles{0U};
+    std::atomic<uint32_t> latency_cycles{0U};
+    std::atomic<uint32_t> max_latency_cycles{0U};
+  };
+
+  /**
+   * @brief Task running one stage
+   *
+   * @tparam I stage index
+   */
+  template <size_t I>
+  class StageTask : public Task {
+  public:
+    explicit StageTask(Pipeline& owner)
+    : Task(owner.name_ + std::to_string(I), PipelineStackSize<typename std::tuple_element<I, stages_t>::type>::value,
+           owner.priority_, owner.core_id_),
+      owner_{owner} {
+      auto& storage{std::get<I>(owner.task_storage_)};
+      setStaticStorage(storage.stack, &storage.tcb);
+      setParkOnFinish(true);
+    }
+
+  private:
+    void run(void* args) override {
+      owner_.template runStage<I>();
+    }
+
+    Pipeline& owner_;
+  };
+
+  /**
+   * @brief Stack and control block of the stage task
+   *
+   * @tparam Stage stage type
+   */
+  template <typename Stage>
+  struct TaskStorage {
+    static_assert(PipelineStackSize<Stage>::value <= UINT16_MAX, "stage stack size is too large");
+
+    StaticTask_t tcb;
+    StackType_t stack[PipelineStackSize<Stage>::value];
+  };
+
+  template <typename Sequence>
+  struct TaskTuple;
+
+  template <size_t... I>
+  struct TaskTuple<std::index_sequence<I...>> {
+    using type = std::tuple<StageTask<I>...>;
+    using owners_t = std::tuple<typename std::enable_if<(I < kStages), Pipeline&>::type...>;
+  };
+
+  using tasks_t = TaskTuple<std::index_sequence_for<Stages...>>;
+
+  template <size_t... I>
+  typename tasks_t::owners_t owners(std::index_sequence<I...>) {
+    return typename tasks_t::owners_t{((void)I, *this)...};
+  }
+
+  template <size_t... I>
+  void startTasks(std::index_sequence<I...>) {
+    (std::get<I>(tasks_).start(), ...);
+  }
+
+  template <size_t... I>
+  bool joinTasks(std::index_sequence<I...>, const uint32_t timeout_ms) {
+    return (std::get<I>(tasks_).join(timeout_ms) && ...);
+  }
+
+  /**
+   * @brief Wait until the finished stage task blocks in park(). Deleting a task which does not run
+   * releases it at once, a running one would be left to the idle task.
+   *
+   * @tparam I stage index
+   */
+  template <size_t I>
+  void waitParked() {
+    const TaskHandle_t handle{std::get<I>(tasks_).handle()};
+    for (;;) {
+      const eTaskState state{eTaskGetState(handle)};
+      if ((eBlocked == state) || (eSuspended == state)) {
+        return;
+      }
+      vTaskDelay(1);
+    }
+  }
+
+  template <size_t... I>
+  void waitParked(std::index_sequence<I...>) {
+    (waitParked<I>(), ...);
+  }
+
+  /**
+   * @brief Pass the message to the next stage or to the output queue, blocks while it is full
+   *
+   * @tparam I index of the sending stage
+   * @param item message
+   */
+  template <size_t I, typename Item>
+  void forward(const Item& item) {
+    if constexpr (I + 1U < kStages) {
+      while (!std::get<I + 1U>(queues_).enqueueBack(item, DEFAULT_PIPELINE_TIMEOUT)) {
+      }
+    } else if constexpr (!std::is_void<output_type>::value) {
+      while (!output_.enqueueBack(item, DEFAULT_PIPELINE_TIMEOUT)) {
+      }
+    }
+  }
+
+  static void updateMax(std::atomic<uint32_t>& max, const uint32_t value) {
+    if (value > max.load(std::memory_order_relaxed)) {
+      max.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Stage task loop
+   *
+   * @tparam I stage index
+   */
+  template <size_t I>
+  void runStage() {
+    using stage_t = typename std::tuple_element<I, stages_t>::type;
+    using in_t = typename stage_t::input_type;
+    using out_t = typename stage_t::output_type;
+    static_assert(std::is_trivially_copyable<in_t>::value, "messages are copied by kernel queues");
+
+    stage_t& stage{std::get<I>(stages_)};
+    Counters& counters{counters_[I]};
+    PipelineItem<in_t> item;
+    for (;;) {
+      if (!std::get<I>(queues_).receive(item, DEFAULT_PIPELINE_TIMEOUT)) {
+        continue;
+      }
+      if (item.stop) {
+        if constexpr (!std::is_void<out_t>::value) {
+          PipelineItem<out_t> marker{};
+          marker.stop = true;
+          forward<I>(marker);
+        }
+        return;
+      }
+
+      const uint32_t started{CPU_CYCLE_COUNT()};
+      bool passed{false};
+      uint32_t finished{0U};
+      if constexpr (std::is_void<out_t>::value) {
+        passed = stage.process(item.value);
+        finished = CPU_CYCLE_COUNT();
+      } else {
+        PipelineItem<out_t> next{};
+        passed = stage.process(item.value, next.value);
+        finished = CPU_CYCLE_COUNT();
+        if (passed) {
+          /*
+            Backpressure from the next stage is accounted apart from the processing time
+          */
+          next.enqueued_at = finished;
+          forward<I>(next);
+          const uint32_t blocked{CPU_CYCLE_COUNT() - finished};
+          counters.blocked_cycles.fetch_add(blocked, std::memory_order_relaxed);
+          updateMax(counters.max_blocked_cycles, blocked);
+        }
+      }
+
+      counters.processed.fetch_add(1U, std::memory_order_relaxed);
+      if (!passed) {
+        counters.dropped.fetch_add(1U, std::memory_order_relaxed);
+      }
+      counters.busy_cycles.fetch_add(finished - started, std::memory_order_relaxed);
+      updateMax(counters.max_busy_cycles, finished - started);
+      counters.latency_cycles.fetch_add(finished - item.enqueued_at, std::memory_order_relaxed);
+      updateMax(counters.max_latency_cycles, finished - item.enqueued_at);
+    }
+  }
+
+  /**
+   * @brief Stage tasks configuration
+   *
+   */
+  const std::string name_;
+  const uint8_t priority_;
+  const BaseType_t core_id_;
+
+  /**
+   * @brief Stage objects
+   *
+   */
+  stages_t stages_{};
+
+  /**
+   * @brief Input queue of every stage
+   *
+   */
+  std::tuple<StaticQueue<PipelineItem<typename Stages::input_type>, PipelineQueueDepth<Stages>::value>...> queues_{};
+
+  /**
+   * @brief Output queue of the last stage
+   *
+   */
+  typename OutputQueue<output_type>::type output_{};
+
+  /**
+   * @brief Per stage statistics
+   *
+   */
+  std::array<Counters, kStages> counters_{};
+
+  /**
+   * @brief Set after shutdown()
+   *
+   */
+  std::atomic<bool> closed_{false};
+
+  /**
+   * @brief Number of push() calls in progress
+   *
+   */
+  std::atomic<uint32_t> pushing_{0U};
+
+  /**
+   * @brief Set by start()
+   *
+   */
+  bool started_{false};
+
+  /**
+   * @brief Stage task stacks and control blocks
+   *
+   */
+  std::tuple<TaskStorage<Stages>...> task_storage_{};
+
+  /**
+   * @brief Stage tasks
+   *
+   */
+  typename tasks_t::type tasks_{owners(std::index_sequence_for<Stages...>{})};
+};
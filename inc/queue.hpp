@@ -4,6 +4,7 @@
 #include "config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "trace.hpp"
 
 /**
  * @brief Template C++ wrapper for static queue operations
@@ -31,8 +32,11 @@ public:
    * @return false otherwise
    */
   bool enqueueBack(const T& msg, const uint32_t timeout_ms = 0u) {
-    return pdTRUE == (IS_IN_ISR() ? xQueueSendToBackFromISR(queue_handle_, &msg, NULL)
-                                  : xQueueSendToBack(queue_handle_, &msg, pdMS_TO_TICKS(timeout_ms)));
+    TRACE_START(trace_start);
+    const bool ret{pdTRUE == (IS_IN_ISR() ? xQueueSendToBackFromISR(queue_handle_, &msg, NULL)
+                                          : xQueueSendToBack(queue_handle_, &msg, pdMS_TO_TICKS(timeout_ms)))};
+    TRACE_EVENT(ret ? TraceEvent::kQueueSend : TraceEvent::kQueueSendTimeout, queue_handle_, trace_start, 0U);
+    return ret;
   }
 
   /**
@@ -44,8 +48,11 @@ public:
    * @return false otherwise
    */
   bool enqueueFront(const T& msg, const uint32_t timeout_ms = 0u) {
-    return pdTRUE == (IS_IN_ISR() ? xQueueSendToFrontFromISR(queue_handle_, &msg, NULL)
-                                  : xQueueSendToFront(queue_handle_, &msg, pdMS_TO_TICKS(timeout_ms)));
+    TRACE_START(trace_start);
+    const bool ret{pdTRUE == (IS_IN_ISR() ? xQueueSendToFrontFromISR(queue_handle_, &msg, NULL)
+                                          : xQueueSendToFront(queue_handle_, &msg, pdMS_TO_TICKS(timeout_ms)))};
+    TRACE_EVENT(ret ? TraceEvent::kQueueSend : TraceEvent::kQueueSendTimeout, queue_handle_, trace_start, 1U);
+    return ret;
   }
 
   /**
@@ -70,8 +77,11 @@ public:
    * @return false otherwise
    */
   bool receive(T& out, const uint32_t timeout_ms = 0) {
-    return pdTRUE == (IS_IN_ISR() ? xQueueReceiveFromISR(queue_handle_, &out, NULL)
-                                  : xQueueReceive(queue_handle_, &out, pdMS_TO_TICKS(timeout_ms)));
+    TRACE_START(trace_start);
+    const bool ret{pdTRUE == (IS_IN_ISR() ? xQueueReceiveFromISR(queue_handle_, &out, NULL)
+                                          : xQueueReceive(queue_handle_, &out, pdMS_TO_TICKS(timeout_ms)))};
+    TRACE_EVENT(ret ? TraceEvent::kQueueReceive : TraceEvent::kQueueReceiveTimeout, queue_handle_, trace_start, 0U);
+    return ret;
   }
 
   /**
@@ -118,6 +128,16 @@ public:
     return queue_handle_;
   }
 
+protected:
+  /**
+   * @brief Construct a new Queue object from the queue created by a derived class
+   *
+   * @param handle queue handler
+   */
+  explicit Queue(QueueHandle_t handle) : queue_handle_{handle} {
+    assert(NULL != queue_handle_);
+  }
+
 private:
   /**
    * @brief Static queue handler
@@ -125,3 +145,35 @@ private:
    */
   QueueHandle_t queue_handle_{NULL};
 };
+
+/**
+ * @brief Storage of StaticQueue, a separate base class so it is initialized before the queue
+ *
+ * @tparam T type of messages in queue
+ * @tparam length queue length
+ */
+template <typename T, size_t length>
+struct StaticQueueStorage {
+  StaticQueue_t control_;
+  uint8_t buffer_[length * sizeof(T)];
+};
+
+/**
+ * @brief Template queue keeping its storage inside of the object instead of the heap
+ *
+ * @tparam T type of messages in queue
+ * @tparam length queue length
+ */
+template <typename T, size_t length>
+class StaticQueue : private StaticQueueStorage<T, length>, public Queue<T, length> {
+public:
+  /**
+   * @brief Construct a new Static Queue object
+   *
+   */
+  StaticQueue() : Queue<T, length>(xQueueCreateStatic(length, sizeof(T), this->buffer_, &this->control_)) {
+  }
+
+  StaticQueue(const StaticQueue&) = delete;
+  StaticQueue& operator=(const StaticQueue&) = delete;
+};
@@ -2,7 +2,9 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <atomic>
 #include <string>
+#include "wait_list.hpp"
 
 /**
  * @class Task
@@ -18,13 +20,21 @@ public:
    */
   static constexpr uint32_t kTaskDefaultPriority{1U};
 
+  /**
+   * @brief core id value to place the task on the least loaded core at start()
+   * and let LoadBalancer move it later
+   *
+   */
+  static constexpr BaseType_t kCoreAuto{-2};
+
   /**
    * @brief Construct a new Task object
    *
    * @param task_name name of task
    * @param stack_size stack size
    * @param priority task priority
-   * @param core_id core id
+   * @param core_id core id, tskNO_AFFINITY to let the scheduler run the task on any core
+   * or kCoreAuto for automatic placement
    */
   explicit Task(const std::string& task_name = "Task", const uint16_t stack_size = configMINIMAL_STACK_SIZE,
                 const uint8_t priority = kTaskDefaultPriority, const BaseType_t core_id = 0);
@@ -67,6 +77,78 @@ public:
    */
   void stop();
 
+  /**
+   * @brief Wait until run() returns or the task is stopped. Several tasks can join at the same time,
+   * the calling task waits on notification index WaitList::kNotifyIndex.
+   *
+   * @param timeout_ms maximum timeout specified in ms, portMAX_DELAY to wait forever
+   * @return true if the task has finished, false on timeout
+   */
+  bool join(const uint32_t timeout_ms = portMAX_DELAY);
+
+  /**
+   * @brief Get the value set by run() with setResult()
+   *
+   * @return result of the last finished run
+   */
+  int32_t result() const;
+
+  /**
+   * @brief Keep the task parked instead of deleting it when run() returns,
+   * start() then re-arms the same task with new data. Should be set before start().
+   *
+   * @param park true to park the task on finish, false to delete it
+   */
+  void setParkOnFinish(const bool park);
+
+  /**
+   * @brief Check if the task is parked and waits to be re-armed with start()
+   *
+   * @return true if the task is parked, otherwise false
+   */
+  bool isParked() const;
+
+  /**
+   * @brief Create the kernel task in the given memory instead of the heap. Should be set before start(),
+   * the memory has to stay valid until the task is deleted and cleaned up by the idle task.
+   *
+   * @param stack stack buffer of stack_size elements
+   * @param tcb task control block
+   */
+  void setStaticStorage(StackType_t* stack, StaticTask_t* tcb);
+
+  /**
+   * @brief Get the core the task is pinned to
+   *
+   * @return core id, tskNO_AFFINITY for unpinned task
+   */
+  BaseType_t coreId() const;
+
+  /**
+   * @brief Move automatically placed task to another core. The task is moved immediately
+   * when the kernel supports changing core affinity. Otherwise, as on stock ESP-IDF, it is created
+   * again on the target core after run() returned on migrationRequested(), or when the parked task
+   * is re-armed. Tasks with static storage are moved only by re-arming or by starting them again.
+   *
+   * @param core_id target core
+   * @return true if the task was moved immediately, otherwise false
+   */
+  bool migrate(const BaseType_t core_id);
+
+  /**
+   * @brief Check if the task has been asked to move to another core and has not moved yet
+   *
+   * @return true if the migration is pending, otherwise false
+   */
+  bool migrationPending() const;
+
+  /**
+   * @brief Get internal task descriptor @see TaskHandle_t
+   *
+   * @return task descriptor or nullptr if the task is not started
+   */
+  TaskHandle_t handle() const;
+
   /**
    * @brief Task main function to execute
    *
@@ -95,7 +177,44 @@ private:
    */
   static void runTask(void* data);
 
+  /**
+   * @brief Mark the task finished and wake up the joining task
+   *
+   */
+  void complete();
+
+  /**
+   * @brief Park the finished task until it is re-armed
+   *
+   * @return true if the task was re-armed, false if parking is disabled
+   */
+  bool park();
+
+  /**
+   * @brief Create the task on the target core after run() returned for migration,
+   * the calling kernel task has to delete itself afterwards
+   *
+   * @return true if the task continues on the target core, otherwise false
+   */
+  bool relocate();
+
 protected:
+  /**
+   * @brief Set the task result, can be called from run()
+   *
+   * @param result result value
+   */
+  void setResult(const int32_t result);
+
+  /**
+   * @brief Check from run() of automatically placed task if it should move to another core.
+   * When it returns true, run() has to return at once and is called again with the same argument
+   * on the target core. Tasks never checking it are moved only when re-armed or started again.
+   *
+   * @return true if run() has to return for migration, otherwise false
+   */
+  bool migrationRequested();
+
   /**
    * @brief Internal task descriptor @see TaskHandle_t
    *
@@ -138,4 +257,78 @@ private:
    *
    */
   BaseType_t core_id_{};
+
+  /**
+   * @brief Core the kernel task is created on
+   *
+   */
+  volatile BaseType_t placed_core_{};
+
+  /**
+   * @brief Core chosen for automatically placed task
+   *
+   */
+  std::atomic<BaseType_t> target_core_{kCoreAuto};
+
+  /**
+   * @brief flag shows run() has returned for migration, only touched by the task itself
+   *
+   */
+  bool relocate_on_return_{false};
+
+  /**
+   * @brief Lock guarding task_descr_ between stop() and relocate()
+   *
+   */
+  portMUX_TYPE handle_lock_ = portMUX_INITIALIZER_UNLOCKED;
+
+  /**
+   * @brief flag shows relocate() is creating the kernel task on the target core, guarded by handle_lock_
+   *
+   */
+  bool moving_{false};
+
+  /**
+   * @brief flag shows the task is being created on the target core, the new kernel task
+   * waits for the old one to hand over
+   *
+   */
+  std::atomic<bool> relocating_{false};
+
+  /**
+   * @brief flag shows if run() has returned or the task was stopped
+   *
+   */
+  std::atomic<bool> finished_{false};
+
+  /**
+   * @brief flag shows if the parked task was given new work
+   *
+   */
+  std::atomic<bool> rearmed_{false};
+
+  /**
+   * @brief Tasks waiting in join()
+   *
+   */
+  WaitList joiners_;
+
+  /**
+   * @brief Park the task instead of deleting it when run() returns
+   *
+   */
+  bool park_on_finish_{false};
+
+  /**
+   * @brief Stack and control block of the statically allocated task
+   *
+   */
+  StackType_t* static_stack_{nullptr};
+  StaticTask_t* static_tcb_{nullptr};
+
+  /**
+   * @brief Task's result
+   *
+   */
+  volatile int32_t result_{0};
 };
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+#if FREERTOS_UTILS_TRACE
+#include "esp_cpu.h"
+#endif // FREERTOS_UTILS_TRACE
+
+/**
+ * @brief Types of traced events
+ *
+ */
+enum class TraceEvent : uint8_t {
+  kTaskStart = 0U,
+  kTaskStop,
+  kTaskSuspend,
+  kTaskResume,
+  kQueueSend,
+  kQueueSendTimeout,
+  kQueueReceive,
+  kQueueReceiveTimeout,
+  kMutexAcquire,
+  kMutexTimeout,
+  kMutexRelease,
+  kSemaphoreGive,
+  kSemaphoreTake,
+  kSemaphoreTimeout,
+  kEventGroupSet,
+  kEventGroupWait,
+  kEventGroupTimeout,
+};
+
+/**
+ * @brief Binary trace record
+ *
+ * Blocking operations are recorded once on completion, wait_cycles holds the time spent
+ * inside of the operation. Non-blocking operations have zero wait_cycles.
+ */
+struct TraceRecord {
+  uint32_t timestamp;
+  uint32_t wait_cycles;
+  uint32_t task;
+  uint32_t object;
+  uint32_t arg;
+  uint8_t event;
+  uint8_t flags;
+  uint16_t reserved;
+};
+
+/**
+ * @class Trace
+ *
+ * @brief Per-core ring buffers of binary trace records
+ *
+ * Every core writes into its own ring with local interrupts masked, so recording never takes
+ * a lock shared between cores and can be done from ISRs. Old records are overwritten.
+ * The rings are serialized with dump() and converted on the host with tools/trace_to_chrome.py.
+ */
+class Trace {
+public:
+  /**
+   * @brief Record flag set for records made from ISR context
+   *
+   */
+  static constexpr uint8_t kFlagIsr{0x80U};
+
+  /**
+   * @brief Maximum length of object name including terminator
+   *
+   */
+  static constexpr size_t kNameLength{16U};
+
+  /**
+   * @brief Callback used to output serialized trace data
+   *
+   */
+  using writer_t = void (*)(const void* data, size_t size, void* ctx);
+
+  /**
+   * @brief Add a record to the current core ring. This function can be called from any context.
+   *
+   * @param event event type
+   * @param object traced object handle
+   * @param start_cycles cycle counter value at the beginning of the operation
+   * @param arg event specific argument
+   */
+  static void record(TraceEvent event, const void* object, uint32_t start_cycles, uint32_t arg = 0U);
+
+  /**
+   * @brief Add a record of a non-blocking operation with zero wait_cycles to the current core ring.
+   * This function can be called from any context.
+   *
+   * @param event event type
+   * @param object traced object handle
+   * @param arg event specific argument
+   */
+  static void instant(TraceEvent event, const void* object, uint32_t arg = 0U);
+
+  /**
+   * @brief Assign a human readable name to an object handle
+   *
+   * @param object object handle
+   * @param name object name, truncated to kNameLength - 1 characters
+   */
+  static void setName(const void* object, const char* name);
+
+  /**
+   * @brief Enable or disable recording
+   *
+   * @param enabled true to record events, false to drop them
+   */
+  static void setEnabled(bool enabled);
+
+  /**
+   * @brief Drop all recorded events, recording is paused meanwhile
+   *
+   */
+  static void clear();
+
+  /**
+   * @brief Serialize names and records of all cores, recording is paused meanwhile
+   *
+   * @param writer output callback
+   * @param ctx user context passed to the writer
+   * @return number of serialized records
+   */
+  static size_t dump(writer_t writer, void* ctx = nullptr);
+
+  /**
+   * @brief Measure average cost of record() in CPU cycles, recorded events are cleared afterwards
+   *
+   * @param iterations number of records to make
+   * @return average cycles per record
+   */
+  static uint32_t measureCost(uint32_t iterations = 1000U);
+};
+
+#if FREERTOS_UTILS_TRACE
+#define TRACE_START(var) const uint32_t var{CPU_CYCLE_COUNT()}
+#define TRACE_EVENT(event, object, start, arg) Trace::record(event, object, start, arg)
+#define TRACE_INSTANT(event, object, arg) Trace::instant(event, object, arg)
+#define TRACE_NAME(object, name) Trace::setName(object, name)
+#else
+#define TRACE_START(var)
+#define TRACE_EVENT(event, object, start, arg) \
+  do {                                         \
+  } while (0)
+#define TRACE_INSTANT(event, object, arg) \
+  do {                                    \
+  } while (0)
+#define TRACE_NAME(object, name) \
+  do {                           \
+  } while (0)
+#endif // FREERTOS_UTILS_TRACE
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include "binary_semaphore.hpp"
+#include "config.h"
+
+/**
+ * @brief Template multiple buffering for handoff of large frames between one producer and one consumer
+ *
+ * The producer always owns a free buffer to write into and publishes it with a single atomic
+ * exchange, which is safe in ISR or DMA completion callbacks. The consumer always gets the newest
+ * published frame, frames replaced before the consumer took them are counted as dropped.
+ * Frames are never copied.
+ *
+ * Of N buffers one belongs to the producer, one holds the latest published frame and N - 2
+ * belong to the consumer, so the consumer can keep up to N - 3 frames while taking a new one.
+ *
+ * @tparam T frame type
+ * @tparam N number of buffers, at least 3
+ */
+template <typename T, size_t N>
+class MultiBuffer {
+public:
+  /**
+   * @brief Frame counters
+   *
+   */
+  struct Stats {
+    uint32_t published;
+    uint32_t consumed;
+    uint32_t dropped;
+  };
+
+  /**
+   * @brief Construct a new MultiBuffer object
+   *
+   */
+  MultiBuffer() {
+    for (size_t i = 2U; i < N; ++i) {
+      owned_ |= (1UL << i);
+    }
+  }
+
+  MultiBuffer(const MultiBuffer&) = delete;
+  MultiBuffer& operator=(const MultiBuffer&) = delete;
+
+  /**
+   * @brief Get the producer buffer
+   *
+   * @return buffer to write the next frame into
+   */
+  T& back() {
+    return buffers_[back_];
+  }
+
+  /**
+   * @brief Publish the producer buffer as the newest frame and take a free buffer for the next one.
+   * This function can be called from any context.
+   *
+   */
+  void publish() {
+    const uint32_t previous{state_.exchange(back_ | kFresh, std::memory_order_acq_rel)};
+    if (0U != (previous & kFresh)) {
+      dropped_.fetch_add(1U, std::memory_order_relaxed);
+    }
+    back_ = previous & kIndexMask;
+    published_.fetch_add(1U, std::memory_order_relaxed);
+    frame_ready_.tryGive();
+  }
+
+  /**
+   * @brief Check if there is a frame newer than the ones taken by the consumer
+   *
+   * @return true if a new frame is published, otherwise false
+   */
+  bool hasFrame() const {
+    return 0U != (state_.load(std::memory_order_acquire) & kFresh);
+  }
+
+  /**
+   * @brief Take the newest frame, the consumer owns it until release()
+   *
+   * @return pointer to the frame or nullptr if there is no new frame or all consumer buffers are held
+   */
+  const T* acquire() {
+    if (!hasFrame()) {
+      return nullptr;
+    }
+    const uint32_t free{owned_ & ~held_};
+    if (0U == free) {
+      return nullptr;
+    }
+    const uint32_t spare{static_cast<uint32_t>(__builtin_ctz(free))};
+    const uint32_t index{state_.exchange(spare, std::memory_order_acq_rel) & kIndexMask};
+    owned_ = (owned_ & ~(1UL << spare)) | (1UL << index);
+    held_ |= (1UL << index);
+    latest_ = index;
+    consumed_.fetch_add(1U, std::memory_order_relaxed);
+    return &buffers_[index];
+  }
+
+  /**
+   * @brief Give the frame back, it can be reused by the producer afterwards
+   *
+   * @param frame pointer returned by acquire()
+   */
+  void release(const T* frame) {
+    const size_t index{static_cast<size_t>(frame - buffers_.data())};
+    assert(index < N);
+    held_ &= ~(1UL << index);
+  }
+
+  /**
+   * @brief Release all held frames and get the newest one
+   *
+   * @return the newest frame, or the last taken one if nothing new was published,
+   * valid until the next call; nullptr if no frame was published yet
+   */
+  const T* latest() {
+    held_ = 0U;
+    const T* frame{acquire()};
+    if ((nullptr == frame) && (kNoFrame != latest_)) {
+      frame = &buffers_[latest_];
+    }
+    return frame;
+  }
+
+  /**
+   * @brief Wait until a new frame is published
+   *
+   * @param timeout_ms maximum timeout specified in ms
+   * @return true if a new frame is available, false on timeout
+   */
+  bool waitFrame(const uint32_t timeout_ms) {
+    while (!hasFrame()) {
+      if (!frame_ready_.tryTake(timeout_ms)) {
+        return hasFrame();
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Get frame counters
+   *
+   * @return counters snapshot
+   */
+  Stats stats() const {
+    return Stats{published_.load(std::memory_order_relaxed), consumed_.load(std::memory_order_relaxed),
+                 dropped_.load(std::memory_order_relaxed)};
+  }
+
+private:
+  static_assert((N >= 3U) && (N <= 32U), "number of buffers must be within 3..32");
+
+  static constexpr uint32_t kIndexMask{0xFFU};
+  static constexpr uint32_t kFresh{0x100U};
+  static constexpr uint32_t kNoFrame{0xFFFFFFFFU};
+
+  /**
+   * @brief Frame buffers
+   *
+   */
+  std::array<T, N> buffers_{};
+
+  /**
+   * @brief Index of the latest published buffer and the flag showing the consumer has not taken it
+   *
+   */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> state_{1U};
+
+  /**
+   * @brief Producer buffer index
+   *
+   */
+  uint32_t back_{0U};
+
+  /**
+   * @brief Buffers owned by the consumer
+   *
+   */
+  alignas(CACHE_LINE_SIZE) uint32_t owned_{0U};
+
+  /**
+   * @brief Consumer buffers holding acquired frames
+   *
+   */
+  uint32_t held_{0U};
+
+  /**
+   * @brief Last frame taken by the consumer
+   *
+   */
+  uint32_t latest_{kNoFrame};
+
+  /**
+   * @brief Frame counters
+   *
+   */
+  std::atomic<uint32_t> published_{0U};
+  std::atomic<uint32_t> consumed_{0U};
+  std::atomic<uint32_t> dropped_{0U};
+
+  /**
+   * @brief Given on every publish, lets the consumer block for a new frame
+   *
+   */
+  BinarySemaphore frame_ready_;
+};
+
+/**
+ * @brief Triple buffer, the producer and the consumer never wait for each other
+ *
+ * @tparam T frame type
+ */
+template <typename T>
+using TripleBuffer = MultiBuffer<T, 3U>;
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+
+/**
+ * @class WaitList
+ *
+ * @brief FIFO list of tasks blocked on direct task notifications
+ *
+ * Waiter nodes live on the stack of the waiting tasks, so the list never allocates. A waiter
+ * is unlinked by the side that wakes it, which then sends exactly one notification. Waiting uses
+ * the notification FREERTOS_UTILS_WAIT_NOTIFY_INDEX of the calling task. That index belongs to the library,
+ * the application must not notify it, while notifications on index 0 are never taken or sent by
+ * the primitives built on WaitList.
+ */
+class WaitList {
+public:
+  /**
+   * @brief Task notification index owned by the waiting primitives
+   *
+   */
+  static constexpr UBaseType_t kNotifyIndex{FREERTOS_UTILS_WAIT_NOTIFY_INDEX};
+
+  static_assert(configTASK_NOTIFICATION_ARRAY_ENTRIES > 1,
+                "set CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES to 2 or more");
+  static_assert((kNotifyIndex > 0U) && (kNotifyIndex < configTASK_NOTIFICATION_ARRAY_ENTRIES),
+                "notification index 0 belongs to the application");
+  /**
+   * @brief List node of one waiting task
+   *
+   */
+  struct Waiter {
+    TaskHandle_t task{nullptr};
+    Waiter* next{nullptr};
+    bool linked{false};
+  };
+
+  WaitList() = default;
+  WaitList(const WaitList&) = delete;
+  WaitList& operator=(const WaitList&) = delete;
+
+  /**
+   * @brief Append the calling task to the list, must be followed by wait()
+   *
+   * @param waiter node owned by the calling task
+   */
+  void add(Waiter& waiter) {
+    waiter.task = xTaskGetCurrentTaskHandle();
+    waiter.next = nullptr;
+    portENTER_CRITICAL_SAFE(&lock_);
+    waiter.linked = true;
+    if (nullptr == tail_) {
+      head_ = &waiter;
+    } else {
+      tail_->next = &waiter;
+    }
+    tail_ = &waiter;
+    size_.fetch_add(1U);
+    portEXIT_CRITICAL_SAFE(&lock_);
+  }
+
+  /**
+   * @brief Block until the waiter is woken or the timeout expires, the waiter is unlinked on return
+   *
+   * @param waiter node passed to add()
+   * @param ticks timeout in ticks
+   * @return true if the waiter was woken, false on timeout
+   */
+  bool wait(Waiter& waiter, TickType_t ticks) {
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    for (;;) {
+      const bool notified{take(ticks)};
+      if (!isLinked(waiter)) {
+        /*
+          Unlinked by the waking side, its notification must not be left pending
+        */
+        if (!notified) {
+          take(portMAX_DELAY);
+        }
+        return true;
+      }
+      if (pdFALSE != xTaskCheckForTimeOut(&timeout, &ticks)) {
+        if (remove(waiter)) {
+          return false;
+        }
+        take(portMAX_DELAY);
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @brief Unlink the waiter if it is still in the list
+   *
+   * @param waiter node passed to add()
+   * @return true if the waiter was unlinked, false if it has been woken already
+   */
+  bool remove(Waiter& waiter) {
+    bool ret{false};
+    portENTER_CRITICAL_SAFE(&lock_);
+    if (waiter.linked) {
+      Waiter* prev{nullptr};
+      Waiter* node{head_};
+      while (node != &waiter) {
+        prev = node;
+        node = node->next;
+      }
+      unlink(prev, waiter);
+      ret = true;
+    }
+    portEXIT_CRITICAL_SAFE(&lock_);
+    return ret;
+  }
+
+  /**
+   * @brief Withdraw the waiter without blocking on it. If it has been woken already,
+   * the notification sent to the calling task is consumed.
+   *
+   * @param waiter node passed to add()
+   */
+  void cancel(Waiter& waiter) {
+    if (!remove(waiter)) {
+      take(portMAX_DELAY);
+    }
+  }
+
+  /**
+   * @brief Wake the oldest waiter. This function can be called from any context.
+   *
+   * @return true if a waiter was woken, false if the list is empty
+   */
+  bool notifyOne() {
+    if (empty()) {
+      return false;
+    }
+    TaskHandle_t task{nullptr};
+    portENTER_CRITICAL_SAFE(&lock_);
+    if (nullptr != head_) {
+      task = head_->task;
+      unlink(nullptr, *head_);
+    }
+    portEXIT_CRITICAL_SAFE(&lock_);
+    if (nullptr == task) {
+      return false;
+    }
+    if (IS_IN_ISR()) {
+      BaseType_t reschedule{pdFALSE};
+      vTaskNotifyGiveIndexedFromISR(task, kNotifyIndex, &reschedule);
+      portYIELD_FROM_ISR(reschedule);
+    } else {
+      xTaskNotifyGiveIndexed(task, kNotifyIndex);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Wake all tasks waiting at the moment of the call. This function can be called from any context.
+   *
+   * @return number of woken waiters
+   */
+  size_t notifyAll() {
+    size_t count{size_.load()};
+    size_t woken{0U};
+    while ((count-- > 0U) && notifyOne()) {
+      ++woken;
+    }
+    return woken;
+  }
+
+  /**
+   * @brief Check if there are no waiters
+   *
+   * @return true if the list is empty, otherwise false
+   */
+  bool empty() const {
+    return 0U == size_.load();
+  }
+
+private:
+  /**
+   * @brief Take the notification sent by the waking side
+   *
+   * @param ticks timeout in ticks
+   * @return true if the notification was taken, false on timeout
+   */
+  static bool take(const TickType_t ticks) {
+    return ulTaskNotifyTakeIndexed(kNotifyIndex, pdTRUE, ticks) > 0U;
+  }
+
+  bool isLinked(const Waiter& waiter) {
+    portENTER_CRITICAL_SAFE(&lock_);
+    const bool linked{waiter.linked};
+    portEXIT_CRITICAL_SAFE(&lock_);
+    return linked;
+  }
+
+  /**
+   * @brief Unlink the node, must be called with the lock taken
+   *
+   * @param prev previous node or nullptr for the head
+   * @param waiter node to unlink
+   */
+  void unlink(Waiter* prev, Waiter& waiter) {
+    if (nullptr == prev) {
+      head_ = waiter.next;
+    } else {
+      prev->next = waiter.next;
+    }
+    if (tail_ == &waiter) {
+      tail_ = prev;
+    }
+    waiter.linked = false;
+    size_.fetch_sub(1U);
+  }
+
+  /**
+   * @brief Lock protecting the list
+   *
+   */
+  portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+
+  /**
+   * @brief Oldest waiter
+   *
+   */
+  Waiter* head_{nullptr};
+
+  /**
+   * @brief Newest waiter
+   *
+   */
+  Waiter* tail_{nullptr};
+
+  /**
+   * @brief Number of waiters, allows to skip the lock when nobody waits
+   *
+   */
+  std::atomic<size_t> size_{0U};
+};
@@ -0,0 +1,273 @@
+
+#include "load_balancer.hpp"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "esp_log.h"
+
+static const char* const TAG{"LoadBalancer"};
+
+namespace {
+
+struct Entry {
+  Task* task;
+  TaskHandle_t handle;
+  uint32_t last_runtime;
+  uint8_t share;
+  bool pinned;
+};
+
+/**
+ * @brief Runtime of a registered task, taken out of the registry to be computed without the lock
+ *
+ */
+struct Sample {
+  Task* task;
+  TaskHandle_t handle;
+  uint32_t runtime;
+};
+
+portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+Entry entries[LoadBalancer::kMaxTasks]{};
+std::atomic<uint8_t> utilizations[portNUM_PROCESSORS]{};
+std::atomic<bool> measured{false};
+
+}  // namespace
+
+LoadBalancer::LoadBalancer(const uint32_t period_ms, const uint8_t threshold_percent, const uint8_t hysteresis,
+                           const std::string& task_name, const uint16_t stack_size, const uint8_t priority)
+: Task(task_name, stack_size, priority, tskNO_AFFINITY),
+  period_ms_(period_ms),
+  threshold_percent_(threshold_percent),
+  hysteresis_(hysteresis) {
+}
+
+void LoadBalancer::sample() {
+#if (configGENERATE_RUN_TIME_STATS == 1) && (configUSE_TRACE_FACILITY == 1)
+  static uint32_t last_total{0U};
+  static uint32_t last_idle[portNUM_PROCESSORS]{};
+
+  const UBaseType_t capacity{uxTaskGetNumberOfTasks() + 4U};
+  TaskStatus_t* status{static_cast<TaskStatus_t*>(pvPortMalloc(capacity * sizeof(TaskStatus_t)))};
+  if (nullptr == status) {
+    ESP_LOGE(TAG, "LoadBalancer::sample - no memory for %u task records", capacity);
+    return;
+  }
+  uint32_t total{0U};
+  const UBaseType_t count{uxTaskGetSystemState(status, capacity, &total)};
+  const uint32_t elapsed{total - last_total};
+  const bool valid{(0U != last_total) && (0U != elapsed) && (count > 0U)};
+
+  auto runtimeOf = [status, count](const TaskHandle_t handle) {
+    for (UBaseType_t i = 0U; i < count; ++i) {
+      if (status[i].xHandle == handle) {
+        return status[i].ulRunTimeCounter;
+      }
+    }
+    return static_cast<uint32_t>(0U);
+  };
+  auto percentOf = [elapsed](const uint32_t runtime) {
+    const uint64_t percent{static_cast<uint64_t>(runtime) * 100U / elapsed};
+    return static_cast<uint8_t>(percent > 100U ? 100U : percent);
+  };
+
+  for (BaseType_t core = 0; core < portNUM_PROCESSORS; ++core) {
+    const uint32_t idle{runtimeOf(xTaskGetIdleTaskHandleForCore(core))};
+    if (valid) {
+      utilizations[core].store(static_cast<uint8_t>(100U - percentOf(idle - last_idle[core])));
+    }
+    last_idle[core] = idle;
+  }
+
+  /*
+    Look up the runtimes outside the lock, the task may be replaced meanwhile, so the result
+    is stored only if the entry still holds the same task
+  */
+  Sample samples[LoadBalancer::kMaxTasks]{};
+  portENTER_CRITICAL(&lock);
+  for (size_t i = 0U; i < LoadBalancer::kMaxTasks; ++i) {
+    samples[i] = Sample{entries[i].task, (nullptr != entries[i].task) ? entries[i].task->handle() : nullptr, 0U};
+  }
+  portEXIT_CRITICAL(&lock);
+
+  for (Sample& sample : samples) {
+    if (nullptr != sample.handle) {
+      sample.runtime = runtimeOf(sample.handle);
+    }
+  }
+
+  portENTER_CRITICAL(&lock);
+  for (size_t i = 0U; i < LoadBalancer::kMaxTasks; ++i) {
+    Entry& entry{entries[i]};
+    const Sample& sample{samples[i]};
+    if ((nullptr == entry.task) || (sample.task != entry.task)) {
+      continue;
+    }
+    /*
+      A relocated task runs as a new kernel task with its own runtime counter
+    */
+    const bool same_handle{sample.handle == entry.handle};
+    entry.share = (valid && same_handle) ? percentOf(sample.runtime - entry.last_runtime) : 0U;
+    entry.handle = sample.handle;
+    entry.last_runtime = sample.runtime;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  last_total = total;
+  measured.store(measured.load() || valid);
+  vPortFree(status);
+#endif
+}
+
+uint8_t LoadBalancer::utilization(const BaseType_t core_id) {
+  return ((core_id >= 0) && (core_id < portNUM_PROCESSORS)) ? utilizations[core_id].load() : 0U;
+}
+
+BaseType_t LoadBalancer::leastLoadedCore() {
+  size_t tasks[portNUM_PROCESSORS]{};
+  portENTER_CRITICAL(&lock);
+  for (const Entry& entry : entries) {
+    if (nullptr != entry.task) {
+      const BaseType_t core{entry.task->coreId()};
+      if ((core >= 0) && (core < portNUM_PROCESSORS)) {
+        ++tasks[core];
+      }
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+
+  const bool use_load{measured.load()};
+  BaseType_t best{0};
+  for (BaseType_t core = 1; core < portNUM_PROCESSORS; ++core) {
+    const uint8_t load{use_load ? utilization(core) : static_cast<uint8_t>(0U)};
+    const uint8_t best_load{use_load ? utilization(best) : static_cast<uint8_t>(0U)};
+    if ((load < best_load) || ((load == best_load) && (tasks[core] < tasks[best]))) {
+      best = core;
+    }
+  }
+  return best;
+}
+
+bool LoadBalancer::attach(Task& task) {
+  bool ret{false};
+  portENTER_CRITICAL(&lock);
+  Entry* free_entry{nullptr};
+  for (Entry& entry : entries) {
+    if (&task == entry.task) {
+      free_entry = nullptr;
+      ret = true;
+      break;
+    }
+    if ((nullptr == entry.task) && (nullptr == free_entry)) {
+      free_entry = &entry;
+    }
+  }
+  if (nullptr != free_entry) {
+    *free_entry = Entry{&task, nullptr, 0U, 0U, false};
+    ret = true;
+  }
+  portEXIT_CRITICAL(&lock);
+  if (!ret) {
+    ESP_LOGW(TAG, "LoadBalancer::attach - too many tasks, task will not be balanced");
+  }
+  return ret;
+}
+
+void LoadBalancer::detach(Task& task) {
+  /*
+    Wait while the balancer is moving the task, it uses the task object without the lock
+  */
+  for (;;) {
+    bool pinned{false};
+    portENTER_CRITICAL(&lock);
+    for (Entry& entry : entries) {
+      if (&task == entry.task) {
+        pinned = entry.pinned;
+        if (!pinned) {
+          entry.task = nullptr;
+        }
+      }
+    }
+    portEXIT_CRITICAL(&lock);
+    if (!pinned) {
+      return;
+    }
+    vTaskDelay(1);
+  }
+}
+
+void LoadBalancer::run(void* args) {
+  for (;;) {
+    delay(period_ms_);
+    sample();
+    if (measured.load()) {
+      rebalance();
+    }
+  }
+}
+
+void LoadBalancer::onStop() {
+  portENTER_CRITICAL(&lock);
+  for (Entry& entry : entries) {
+    entry.pinned = false;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+void LoadBalancer::rebalance() {
+  BaseType_t hot{0};
+  BaseType_t cold{0};
+  for (BaseType_t core = 1; core < portNUM_PROCESSORS; ++core) {
+    if (utilization(core) > utilization(hot)) {
+      hot = core;
+    }
+    if (utilization(core) < utilization(cold)) {
+      cold = core;
+    }
+  }
+  const uint8_t imbalance{static_cast<uint8_t>(utilization(hot) - utilization(cold))};
+  if (imbalance < threshold_percent_) {
+    streak_ = 0U;
+    return;
+  }
+  if (++streak_ < hysteresis_) {
+    return;
+  }
+  streak_ = 0U;
+
+  /*
+    Move the busiest task which does not turn the cold core into the hot one
+  */
+  Entry* candidate{nullptr};
+  uint8_t share{0U};
+  portENTER_CRITICAL(&lock);
+  for (Entry& entry : entries) {
+    if ((nullptr != entry.task) && !entry.task->migrationPending() && (hot == entry.task->coreId()) &&
+        (entry.share <= imbalance / 2U) && ((nullptr == candidate) || (entry.share > candidate->share)) &&
+        (entry.share > 0U)) {
+      candidate = &entry;
+    }
+  }
+  if (nullptr != candidate) {
+    /*
+      Keeps the task registered, so detach() waits until migrate() returns
+    */
+    candidate->pinned = true;
+    share = candidate->share;
+  }
+  portEXIT_CRITICAL(&lock);
+
+  if (nullptr != candidate) {
+    Task* const task{candidate->task};
+    const bool moved{task->migrate(cold)};
+    if (moved || task->migrationPending()) {
+      ESP_LOGI(TAG, "LoadBalancer::rebalance - task %p (%u%%) %s core %d", task->handle(), share,
+               moved ? "moved to" : "will move to", static_cast<int>(cold));
+    } else {
+      ESP_LOGD(TAG, "LoadBalancer::rebalance - task %p cannot move while running", task->handle());
+    }
+    portENTER_CRITICAL(&lock);
+    candidate->pinned = false;
+    portEXIT_CRITICAL(&lock);
+  }
+}
@@ -2,16 +2,33 @@
 #include "task.hpp"
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include "config.h"
 #include "esp_log.h"
 #include "interrupt_locker.hpp"
+#include "load_balancer.hpp"
+#include "trace.hpp"
 
 static const char* const TAG{"Task"};
 
 Task::Task(const std::string& taskName, const uint16_t stackSize, const uint8_t priority, const BaseType_t coreID)
-: is_running_(false), task_name_(taskName), stack_size_(stackSize), priority_(priority), core_id_(coreID) {
+: is_running_(false),
+  task_name_(taskName),
+  stack_size_(stackSize),
+  priority_(priority),
+  core_id_(coreID),
+  placed_core_(coreID) {
 }
 
 Task::~Task() {
+  if (kCoreAuto == core_id_) {
+    LoadBalancer::detach(*this);
+  }
+  /*
+    Parked task outlives its run() and has to be deleted together with the object
+  */
+  if (park_on_finish_ && (nullptr != task_descr_) && finished_.load()) {
+    vTaskDelete(task_descr_);
+  }
 }
 
 void Task::delay(const uint32_t ms) {
@@ -20,41 +37,273 @@ void Task::delay(const uint32_t ms) {
 
 void Task::runTask(void* pTaskInstance) {
   Task* pTask = static_cast<Task*>(pTaskInstance);
-  pTask->run(pTask->task_arg_);
+  if (pTask->relocating_.exchange(false)) {
+    ulTaskNotifyTakeIndexed(WaitList::kNotifyIndex, pdTRUE, portMAX_DELAY);
+  }
+  do {
+    pTask->run(pTask->task_arg_);
+    if (pTask->relocate()) {
+      /*
+        The task continues on the target core
+      */
+      vTaskDelete(nullptr);
+    }
+  } while (pTask->park());
   pTask->stop();
 }
 
 void Task::start(void* taskData) {
+  if ((task_descr_ != nullptr) && isParked()) {
+    if (migrationPending()) {
+      /*
+        Parked task is moved to the target core by creating it again. It is deleted once blocked
+        in park(), the kernel then releases it at once, so static storage can be reused right away
+      */
+      for (eTaskState state{eTaskGetState(task_descr_)}; (eBlocked != state) && (eSuspended != state);
+           state = eTaskGetState(task_descr_)) {
+        vTaskDelay(1);
+      }
+      vTaskDelete(task_descr_);
+      task_descr_ = nullptr;
+    } else {
+      /*
+        Re-arm the parked task instead of creating a new one
+      */
+      task_arg_ = taskData;
+      result_ = 0;
+      finished_.store(false);
+      is_running_ = true;
+      rearmed_.store(true);
+      TRACE_INSTANT(TraceEvent::kTaskStart, task_descr_, static_cast<uint32_t>(placed_core_));
+      xTaskNotifyGiveIndexed(task_descr_, WaitList::kNotifyIndex);
+      return;
+    }
+  }
   if (task_descr_ != nullptr) {
     ESP_LOGE(TAG, "Task::start - There might be a task with name: %s already running!", task_name_.c_str());
     delay(500);
     assert(false);
   }
   task_arg_ = taskData;
+  result_ = 0;
+  finished_.store(false);
+  if (kCoreAuto == core_id_) {
+    if (kCoreAuto == target_core_.load()) {
+      target_core_.store(LoadBalancer::leastLoadedCore());
+    }
+    placed_core_ = target_core_.load();
+  }
 
   {
     /*
       Safe updating is_running_ flag, context switches are excluded for a while
     */
     InterruptLocker lock;
-    // assert(pdPASS == ::xTaskCreate(&runTask, task_name_.c_str(), stack_size_, this, priority_, &task_descr_));
-    assert(pdPASS == ::xTaskCreatePinnedToCore(&runTask, task_name_.c_str(), stack_size_, this, priority_, &task_descr_,
-                                               core_id_));
+    if (nullptr != static_stack_) {
+      task_descr_ = ::xTaskCreateStaticPinnedToCore(&runTask, task_name_.c_str(), stack_size_, this, priority_,
+                                                    static_stack_, static_tcb_, placed_core_);
+      assert(nullptr != task_descr_);
+    } else {
+      // assert(pdPASS == ::xTaskCreate(&runTask, task_name_.c_str(), stack_size_, this, priority_, &task_descr_));
+      assert(pdPASS == ::xTaskCreatePinnedToCore(&runTask, task_name_.c_str(), stack_size_, this, priority_,
+                                                 &task_descr_, placed_core_));
+    }
     is_running_ = true;
   }
+  if (kCoreAuto == core_id_) {
+    LoadBalancer::attach(*this);
+  }
+  TRACE_NAME(task_descr_, task_name_.c_str());
+  TRACE_INSTANT(TraceEvent::kTaskStart, task_descr_, static_cast<uint32_t>(placed_core_));
 }
 
 void Task::stop() {
-  if (nullptr == task_descr_) {
+  /*
+    Take the handle over under the lock, a relocation in flight is let finish first
+    so the kernel task it creates is the one deleted here
+  */
+  TaskHandle_t temp{nullptr};
+  for (;;) {
+    portENTER_CRITICAL(&handle_lock_);
+    const bool moving{moving_};
+    if (!moving) {
+      temp = task_descr_;
+      task_descr_ = nullptr;
+    }
+    portEXIT_CRITICAL(&handle_lock_);
+    if (!moving) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+  if (nullptr == temp) {
     return;
   }
-  TaskHandle_t temp = task_descr_;
   onStop();
-  task_descr_ = nullptr;
+  if (kCoreAuto == core_id_) {
+    LoadBalancer::detach(*this);
+  }
+  TRACE_INSTANT(TraceEvent::kTaskStop, temp, 0U);
   is_running_ = false;
+  complete();
   vTaskDelete(temp);
 }
 
+bool Task::join(const uint32_t timeout_ms) {
+  assert(!IS_IN_ISR());
+  assert(xTaskGetCurrentTaskHandle() != task_descr_);
+  if (finished_.load() || (nullptr == task_descr_)) {
+    return true;
+  }
+
+  TimeOut_t timeout;
+  vTaskSetTimeOutState(&timeout);
+  TickType_t ticks{(portMAX_DELAY == timeout_ms) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms)};
+  while (!finished_.load()) {
+    if (pdFALSE != xTaskCheckForTimeOut(&timeout, &ticks)) {
+      break;
+    }
+    WaitList::Waiter waiter;
+    joiners_.add(waiter);
+    /*
+      Pairs with the fence in complete(): either the flag is seen here or the waiter is woken
+    */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (finished_.load()) {
+      joiners_.cancel(waiter);
+      break;
+    }
+    joiners_.wait(waiter, ticks);
+  }
+  return finished_.load();
+}
+
+int32_t Task::result() const {
+  return result_;
+}
+
+void Task::setResult(const int32_t result) {
+  result_ = result;
+}
+
+void Task::setParkOnFinish(const bool park) {
+  park_on_finish_ = park;
+}
+
+bool Task::isParked() const {
+  return park_on_finish_ && (nullptr != task_descr_) && finished_.load();
+}
+
+void Task::setStaticStorage(StackType_t* stack, StaticTask_t* tcb) {
+  assert((nullptr != stack) && (nullptr != tcb));
+  static_stack_ = stack;
+  static_tcb_ = tcb;
+}
+
+BaseType_t Task::coreId() const {
+  return placed_core_;
+}
+
+bool Task::migrate(const BaseType_t core_id) {
+  if ((kCoreAuto != core_id_) || (core_id < 0) || (core_id >= portNUM_PROCESSORS)) {
+    return false;
+  }
+#if (configUSE_CORE_AFFINITY == 1)
+  target_core_.store(core_id);
+  if (nullptr != task_descr_) {
+    vTaskCoreAffinitySet(task_descr_, static_cast<UBaseType_t>(1U << core_id));
+    placed_core_ = core_id;
+    return true;
+  }
+#else
+  /*
+    Running task with static storage cannot be created again before the idle task cleans it up,
+    a parked one is moved when it is re-armed
+  */
+  if ((nullptr == static_stack_) || (nullptr == task_descr_) || isParked()) {
+    target_core_.store(core_id);
+  }
+#endif // configUSE_CORE_AFFINITY
+  return false;
+}
+
+bool Task::migrationPending() const {
+  return (kCoreAuto == core_id_) && (target_core_.load() != placed_core_);
+}
+
+bool Task::migrationRequested() {
+  relocate_on_return_ = migrationPending() && (nullptr == static_stack_);
+  return relocate_on_return_;
+}
+
+TaskHandle_t Task::handle() const {
+  return task_descr_;
+}
+
+void Task::complete() {
+  finished_.store(true);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  joiners_.notifyAll();
+}
+
+bool Task::park() {
+  if (!park_on_finish_) {
+    return false;
+  }
+  TRACE_INSTANT(TraceEvent::kTaskStop, task_descr_, 0U);
+  is_running_ = false;
+  complete();
+  /*
+    Every re-arm gives exactly one notification, take it even if the flag is already set,
+    so it does not leak into the next run()
+  */
+  do {
+    ulTaskNotifyTakeIndexed(WaitList::kNotifyIndex, pdTRUE, portMAX_DELAY);
+  } while (!rearmed_.exchange(false));
+  return true;
+}
+
+bool Task::relocate() {
+  if (!relocate_on_return_) {
+    return false;
+  }
+  relocate_on_return_ = false;
+  portENTER_CRITICAL(&handle_lock_);
+  const TaskHandle_t previous{task_descr_};
+  moving_ = (nullptr != previous);
+  portEXIT_CRITICAL(&handle_lock_);
+  if (nullptr == previous) {
+    /*
+      Stopped meanwhile
+    */
+    return false;
+  }
+  const BaseType_t target{target_core_.load()};
+  relocating_.store(true);
+  TaskHandle_t moved{nullptr};
+  const bool created{pdPASS == ::xTaskCreatePinnedToCore(&runTask, task_name_.c_str(), stack_size_, this,
+                                                         priority_, &moved, target)};
+  portENTER_CRITICAL(&handle_lock_);
+  if (created) {
+    task_descr_ = moved;
+    placed_core_ = target;
+  }
+  moving_ = false;
+  portEXIT_CRITICAL(&handle_lock_);
+  if (!created) {
+    relocating_.store(false);
+    target_core_.store(placed_core_);
+    ESP_LOGW(TAG, "Task::relocate - task %s stays on core %d, no memory", task_name_.c_str(),
+             static_cast<int>(placed_core_));
+    return false;
+  }
+  TRACE_INSTANT(TraceEvent::kTaskStop, previous, 0U);
+  TRACE_NAME(moved, task_name_.c_str());
+  TRACE_INSTANT(TraceEvent::kTaskStart, moved, static_cast<uint32_t>(target));
+  xTaskNotifyGiveIndexed(moved, WaitList::kNotifyIndex);
+  return true;
+}
+
 void Task::suspend() {
   if (task_descr_ == nullptr) {
     return;
@@ -67,6 +316,7 @@ void Task::suspend() {
       Safe updating is_running_ flag, context switches are excluded for a while
     */
     InterruptLocker lock;
+    TRACE_INSTANT(TraceEvent::kTaskSuspend, task_descr_, 0U);
     vTaskSuspend(task_descr_);
     is_running_ = false;
   }
@@ -84,6 +334,7 @@ void Task::resume() {
       Safe updating is_running_ flag, context switches are excluded for a while
     */
     InterruptLocker lock;
+    TRACE_INSTANT(TraceEvent::kTaskResume, task_descr_, 0U);
     vTaskResume(task_descr_);
     is_running_ = true;
   }
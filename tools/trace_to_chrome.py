@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Convert a binary dump produced by Trace::dump() into Chrome trace JSON.
+
+Usage: trace_to_chrome.py trace.bin [trace.json]
+
+Open the result in chrome://tracing or https://ui.perfetto.dev. Every core is shown
+as a separate process and every task as a thread. Cycle counters of different cores
+are not synchronized, so timelines of different cores are only roughly aligned.
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = 0x54545246
+HEADER = struct.Struct("<IHHIHH")
+NAME = struct.Struct("<I16s")
+CORE_HEADER = struct.Struct("<II")
+RECORD = struct.Struct("<IIIIIBBH")
+FLAG_ISR = 0x80
+
+EVENTS = [
+    "TaskStart",
+    "TaskStop",
+    "TaskSuspend",
+    "TaskResume",
+    "QueueSend",
+    "QueueSendTimeout",
+    "QueueReceive",
+    "QueueReceiveTimeout",
+    "MutexAcquire",
+    "MutexTimeout",
+    "MutexRelease",
+    "SemaphoreGive",
+    "SemaphoreTake",
+    "SemaphoreTimeout",
+    "EventGroupSet",
+    "EventGroupWait",
+    "EventGroupTimeout",
+]
+
+
+def parse(data):
+    magic, version, cores, cycles_per_us, names_count, record_size = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != 2 or record_size != RECORD.size:
+        raise ValueError("unsupported trace format")
+    offset = HEADER.size
+    names = {}
+    for _ in range(names_count):
+        obj, raw = NAME.unpack_from(data, offset)
+        names[obj] = raw.split(b"\0", 1)[0].decode("ascii", "replace")
+        offset += NAME.size
+    records = []
+    for _ in range(cores):
+        core, count = CORE_HEADER.unpack_from(data, offset)
+        offset += CORE_HEADER.size
+        base = 0
+        previous = None
+        for _ in range(count):
+            rec = RECORD.unpack_from(data, offset)
+            offset += RECORD.size
+            # Unwrap 32-bit cycle counter, records of one core are in order
+            if previous is not None and rec[0] < previous:
+                base += 1 << 32
+            previous = rec[0]
+            timestamp, wait, task, obj, arg, event, flags, _ = rec
+            records.append((core, base + timestamp, wait, task, obj, event, flags, arg))
+    return cycles_per_us, names, records
+
+
+def convert(cycles_per_us, names, records):
+    def label(obj):
+        return names.get(obj, "0x%08x" % obj)
+
+    out = []
+    for core in sorted({r[0] for r in records}):
+        out.append({"ph": "M", "name": "process_name", "pid": core, "args": {"name": "core %d" % core}})
+    threads = set()
+    for core, timestamp, wait, task, obj, event, flags, arg in records:
+        tid = "isr" if flags & FLAG_ISR else task
+        if (core, tid) not in threads:
+            threads.add((core, tid))
+            name = "ISR" if tid == "isr" else label(task)
+            out.append({"ph": "M", "name": "thread_name", "pid": core, "tid": tid, "args": {"name": name}})
+        kind = EVENTS[event] if event < len(EVENTS) else "Event%d" % event
+        entry = {
+            "name": "%s %s" % (kind, label(obj)),
+            "cat": kind,
+            "pid": core,
+            "tid": tid,
+            "args": {"object": label(obj), "arg": arg, "wait_cycles": wait},
+        }
+        if wait:
+            entry.update({"ph": "X", "ts": (timestamp - wait) / cycles_per_us, "dur": wait / cycles_per_us})
+        else:
+            entry.update({"ph": "i", "s": "t", "ts": timestamp / cycles_per_us})
+        out.append(entry)
+    return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    with open(sys.argv[1], "rb") as src:
+        result = convert(*parse(src.read()))
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "w") as dst:
+            json.dump(result, dst)
+    else:
+        json.dump(result, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+
+#include "trace.hpp"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+#include <atomic>
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+
+#if FREERTOS_UTILS_TRACE
+
+static_assert(0U == (FREERTOS_UTILS_TRACE_DEPTH & (FREERTOS_UTILS_TRACE_DEPTH - 1U)),
+              "trace depth must be a power of two");
+static_assert(sizeof(TraceRecord) == 24U, "unexpected trace record layout");
+
+namespace {
+
+constexpr uint32_t kTraceMagic{0x54545246U};  // "FRTT"
+constexpr uint16_t kTraceVersion{2U};
+constexpr size_t kMaxNames{32U};
+
+struct alignas(CACHE_LINE_SIZE) TraceRing {
+  uint32_t head;
+  TraceRecord records[FREERTOS_UTILS_TRACE_DEPTH];
+};
+
+struct TraceName {
+  uint32_t object;
+  char name[Trace::kNameLength];
+};
+
+struct TraceHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t cores;
+  uint32_t cycles_per_us;
+  uint16_t names;
+  uint16_t record_size;
+};
+
+struct TraceCoreHeader {
+  uint32_t core;
+  uint32_t count;
+};
+
+TraceRing rings[portNUM_PROCESSORS]{};
+TraceName names[kMaxNames]{};
+size_t names_count{0U};
+portMUX_TYPE names_lock = portMUX_INITIALIZER_UNLOCKED;
+std::atomic<bool> enabled{true};
+
+void write(const TraceEvent event, const void* object, const bool instant, const uint32_t start_cycles,
+           const uint32_t arg) {
+  const bool isr{IS_IN_ISR()};
+  const UBaseType_t state{portSET_INTERRUPT_MASK_FROM_ISR()};
+  const uint32_t core{CURRENT_CORE_ID()};
+  TraceRing& ring{rings[core]};
+  TraceRecord& rec{ring.records[ring.head & (FREERTOS_UTILS_TRACE_DEPTH - 1U)]};
+  ++ring.head;
+  rec.timestamp = CPU_CYCLE_COUNT();
+  rec.wait_cycles = instant ? 0U : rec.timestamp - start_cycles;
+  rec.task = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle()));
+  rec.object = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(object));
+  rec.event = static_cast<uint8_t>(event);
+  rec.flags = static_cast<uint8_t>(core | (isr ? Trace::kFlagIsr : 0U));
+  rec.arg = arg;
+  rec.reserved = 0U;
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+}  // namespace
+
+void Trace::record(const TraceEvent event, const void* object, const uint32_t start_cycles, const uint32_t arg) {
+  if (enabled.load(std::memory_order_relaxed)) {
+    write(event, object, false, start_cycles, arg);
+  }
+}
+
+void Trace::instant(const TraceEvent event, const void* object, const uint32_t arg) {
+  if (enabled.load(std::memory_order_relaxed)) {
+    write(event, object, true, 0U, arg);
+  }
+}
+
+void Trace::setName(const void* object, const char* name) {
+  const uint32_t key{static_cast<uint32_t>(reinterpret_cast<uintptr_t>(object))};
+  portENTER_CRITICAL(&names_lock);
+  size_t index{0U};
+  while (index < names_count && names[index].object != key) {
+    ++index;
+  }
+  if (index < kMaxNames) {
+    names[index].object = key;
+    strncpy(names[index].name, name, kNameLength - 1U);
+    names[index].name[kNameLength - 1U] = '\0';
+    if (index == names_count) {
+      ++names_count;
+    }
+  }
+  portEXIT_CRITICAL(&names_lock);
+}
+
+void Trace::setEnabled(const bool value) {
+  enabled.store(value, std::memory_order_relaxed);
+}
+
+void Trace::clear() {
+  const bool was_enabled{enabled.exchange(false)};
+  /*
+    Let records started on the other core before the flag was cleared to complete
+  */
+  vTaskDelay(1);
+  for (TraceRing& ring : rings) {
+    ring.head = 0U;
+  }
+  enabled.store(was_enabled);
+}
+
+size_t Trace::dump(writer_t writer, void* ctx) {
+  const bool was_enabled{enabled.exchange(false)};
+  /*
+    Let records started on the other core before the flag was cleared to complete
+  */
+  vTaskDelay(1);
+
+  portENTER_CRITICAL(&names_lock);
+  const size_t count_names{names_count};
+  portEXIT_CRITICAL(&names_lock);
+
+  const TraceHeader header{kTraceMagic,
+                           kTraceVersion,
+                           static_cast<uint16_t>(portNUM_PROCESSORS),
+                           esp_rom_get_cpu_ticks_per_us(),
+                           static_cast<uint16_t>(count_names),
+                           static_cast<uint16_t>(sizeof(TraceRecord))};
+  writer(&header, sizeof(header), ctx);
+  writer(names, count_names * sizeof(TraceName), ctx);
+
+  size_t total{0U};
+  for (uint32_t core = 0U; core < portNUM_PROCESSORS; ++core) {
+    const TraceRing& ring{rings[core]};
+    const uint32_t count{ring.head < FREERTOS_UTILS_TRACE_DEPTH ? ring.head : FREERTOS_UTILS_TRACE_DEPTH};
+    const TraceCoreHeader core_header{core, count};
+    writer(&core_header, sizeof(core_header), ctx);
+    /*
+      Records are written oldest first
+    */
+    const uint32_t first{(ring.head - count) & (FREERTOS_UTILS_TRACE_DEPTH - 1U)};
+    const uint32_t tail{FREERTOS_UTILS_TRACE_DEPTH - first < count ? FREERTOS_UTILS_TRACE_DEPTH - first : count};
+    writer(&ring.records[first], tail * sizeof(TraceRecord), ctx);
+    writer(&ring.records[0], (count - tail) * sizeof(TraceRecord), ctx);
+    total += count;
+  }
+
+  enabled.store(was_enabled);
+  return total;
+}
+
+uint32_t Trace::measureCost(const uint32_t iterations) {
+  const bool was_enabled{enabled.exchange(true)};
+  const uint32_t start{CPU_CYCLE_COUNT()};
+  for (uint32_t i = 0U; i < iterations; ++i) {
+    record(TraceEvent::kSemaphoreGive, nullptr, start, 0U);
+  }
+  const uint32_t elapsed{CPU_CYCLE_COUNT() - start};
+  enabled.store(was_enabled);
+  clear();
+  return (iterations > 0U) ? elapsed / iterations : 0U;
+}
+
+#endif // FREERTOS_UTILS_TRACE